@@ -0,0 +1,237 @@
+#include "assets.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+static const char ASSET_CACHE_MAGIC[4] = {'B', 'R', 'K', 'A'};
+constexpr uint32_t ASSET_CACHE_VERSION = 1;
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Start of a cache file, followed by pixelBytes of raw pixels. Written and
+// read on the same machine, so it is stored as is.
+struct AssetCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t sourceHash; // FNV-1a of the source file
+  int32_t width;
+  int32_t height;
+  int32_t format; // PixelFormat
+  uint32_t pixelBytes;
+};
+
+using AssetClock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------------
+// Global Variables
+//------------------------------------------------------------------------------------
+static std::thread loaderThread;
+static AssetClock::time_point loaderStart;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void LoaderThread(TextureAsset *assets, int count);
+static void DecodeAsset(TextureAsset &asset);
+static bool ReadSourceFile(const char *fileName, std::vector<uint8_t> &data);
+static uint64_t HashBytes(const std::vector<uint8_t> &data);
+static bool ReadCache(const std::string &fileName, uint64_t sourceHash,
+                      int width, int height, Image &image);
+static bool WriteCache(const std::string &fileName, uint64_t sourceHash,
+                       const Image &image);
+static float GetMilliseconds(AssetClock::time_point since);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void StartAssetLoader(TextureAsset *assets, int count) {
+  loaderStart = AssetClock::now();
+  loaderThread = std::thread(LoaderThread, assets, count);
+}
+
+bool UpdateAssets(TextureAsset *assets, int count) {
+  bool uploaded = false;
+  for (int i = 0; i < count; i++) {
+    TextureAsset &asset = assets[i];
+    if (asset.status.load(std::memory_order_acquire) != ASSET_DECODED)
+      continue;
+
+    const AssetClock::time_point start = AssetClock::now();
+    asset.texture = LoadTextureFromImage(asset.image);
+    UnloadImage(asset.image);
+    asset.image = {0};
+    asset.timings.uploadMs = GetMilliseconds(start);
+    asset.timings.readyMs = GetMilliseconds(loaderStart);
+    if (asset.texture.id == 0) {
+      asset.status.store(ASSET_FAILED);
+      TraceLog(LOG_WARNING, "Failed to upload %s.", asset.fileName);
+      continue;
+    }
+    asset.status.store(ASSET_READY);
+    uploaded = true;
+    TraceLog(LOG_INFO,
+             "GAME: %s ready after %.1f ms (read %.1f, %s %.1f, upload %.1f)",
+             asset.fileName, asset.timings.readyMs, asset.timings.readMs,
+             asset.timings.cached ? "cache" : "decode",
+             asset.timings.decodeMs, asset.timings.uploadMs);
+  }
+  return uploaded;
+}
+
+void UnloadAssets(TextureAsset *assets, int count) {
+  if (loaderThread.joinable())
+    loaderThread.join();
+  for (int i = 0; i < count; i++) {
+    TextureAsset &asset = assets[i];
+    if (asset.image.data != nullptr)
+      UnloadImage(asset.image);
+    if (asset.texture.id > 0)
+      UnloadTexture(asset.texture);
+    asset.image = {0};
+    asset.texture = {0};
+    asset.status.store(ASSET_PENDING);
+  }
+}
+
+void LoaderThread(TextureAsset *assets, int count) {
+  for (int i = 0; i < count; i++)
+    DecodeAsset(assets[i]);
+}
+
+// Cache hit: one read of the raw pixels. Miss: decode, downscale to the draw
+// size and write the cache for the next launch.
+void DecodeAsset(TextureAsset &asset) {
+  AssetClock::time_point start = AssetClock::now();
+  std::vector<uint8_t> source;
+  if (!ReadSourceFile(asset.fileName, source)) {
+    TraceLog(LOG_WARNING, "Failed to read %s.", asset.fileName);
+    asset.status.store(ASSET_FAILED);
+    return;
+  }
+  const uint64_t sourceHash = HashBytes(source);
+  asset.timings.readMs = GetMilliseconds(start);
+
+  start = AssetClock::now();
+  const std::string cacheFileName = std::string(asset.fileName) + ".cache";
+  Image image = {0};
+  asset.timings.cached = ReadCache(cacheFileName, sourceHash, asset.width,
+                                   asset.height, image);
+  if (!asset.timings.cached) {
+    image = LoadImageFromMemory(GetFileExtension(asset.fileName),
+                                source.data(),
+                                static_cast<int>(source.size()));
+    if (image.data == nullptr) {
+      TraceLog(LOG_WARNING, "Failed to decode %s.", asset.fileName);
+      asset.status.store(ASSET_FAILED);
+      return;
+    }
+    if (image.width > asset.width || image.height > asset.height)
+      ImageResize(&image, std::min(image.width, asset.width),
+                  std::min(image.height, asset.height));
+    if (!WriteCache(cacheFileName, sourceHash, image)) {
+      TraceLog(LOG_WARNING, "Failed to write asset cache %s.",
+               cacheFileName.c_str());
+    }
+  }
+  asset.timings.decodeMs = GetMilliseconds(start);
+
+  asset.image = image;
+  asset.status.store(ASSET_DECODED, std::memory_order_release);
+}
+
+bool ReadSourceFile(const char *fileName, std::vector<uint8_t> &data) {
+  FILE *file = std::fopen(fileName, "rb");
+  if (file == nullptr)
+    return false;
+  uint8_t chunk[1 << 16];
+  size_t read = 0;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    data.insert(data.end(), chunk, chunk + read);
+  const bool valid = std::ferror(file) == 0 && !data.empty();
+  std::fclose(file);
+  return valid;
+}
+
+uint64_t HashBytes(const std::vector<uint8_t> &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint8_t byte : data) {
+    hash ^= byte;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Accepts the cache only if it was built from the same source bytes and fits
+// the current draw size
+bool ReadCache(const std::string &fileName, uint64_t sourceHash, int width,
+               int height, Image &image) {
+  FILE *file = std::fopen(fileName.c_str(), "rb");
+  if (file == nullptr)
+    return false;
+
+  AssetCacheHeader header = {0};
+  bool valid =
+      std::fread(&header, sizeof(header), 1, file) == 1 &&
+      std::equal(header.magic, header.magic + 4, ASSET_CACHE_MAGIC) &&
+      header.version == ASSET_CACHE_VERSION &&
+      header.sourceHash == sourceHash && header.width > 0 &&
+      header.width <= width && header.height > 0 &&
+      header.height <= height &&
+      header.pixelBytes == static_cast<uint32_t>(GetPixelDataSize(
+                               header.width, header.height, header.format));
+
+  if (valid) {
+    image.data = MemAlloc(static_cast<int>(header.pixelBytes));
+    valid = image.data != nullptr &&
+            std::fread(image.data, 1, header.pixelBytes, file) ==
+                header.pixelBytes;
+    if (valid) {
+      image.width = header.width;
+      image.height = header.height;
+      image.mipmaps = 1;
+      image.format = header.format;
+    } else {
+      MemFree(image.data);
+      image = {0};
+    }
+  }
+  std::fclose(file);
+  return valid;
+}
+
+bool WriteCache(const std::string &fileName, uint64_t sourceHash,
+                const Image &image) {
+  AssetCacheHeader header = {0};
+  std::copy(ASSET_CACHE_MAGIC, ASSET_CACHE_MAGIC + 4, header.magic);
+  header.version = ASSET_CACHE_VERSION;
+  header.sourceHash = sourceHash;
+  header.width = image.width;
+  header.height = image.height;
+  header.format = image.format;
+  header.pixelBytes = static_cast<uint32_t>(
+      GetPixelDataSize(image.width, image.height, image.format));
+
+  FILE *file = std::fopen(fileName.c_str(), "wb");
+  if (file == nullptr)
+    return false;
+  const bool written =
+      std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+      std::fwrite(image.data, 1, header.pixelBytes, file) ==
+          header.pixelBytes;
+  return std::fclose(file) == 0 && written;
+}
+
+float GetMilliseconds(AssetClock::time_point since) {
+  return std::chrono::duration<float, std::milli>(AssetClock::now() - since)
+      .count();
+}
@@ -0,0 +1,55 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "raylib.h"
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Texture loading off the main thread. A loader thread decodes the images at
+// launch, downscales them to the size they are drawn at and keeps the raw
+// pixels in a cache file next to the source, keyed by the source's hash, so
+// later launches skip the decode. The main thread only uploads to the GPU.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+enum AssetStatus {
+  ASSET_PENDING, // Queued or being decoded
+  ASSET_DECODED, // image holds the pixels, waiting for the upload
+  ASSET_READY,   // texture is on the GPU
+  ASSET_FAILED
+};
+
+struct AssetTimings {
+  float readMs;   // Source file read and hashed
+  float decodeMs; // Decode and downscale, or the cache read
+  float uploadMs; // GPU upload on the main thread
+  float readyMs;  // From StartAssetLoader() to the texture being ready
+  bool cached;    // Pixels came from the cache file
+};
+
+struct TextureAsset {
+  const char *fileName;
+  int width;  // Size the texture is drawn at; larger images are downscaled
+  int height;
+  std::atomic<int> status; // AssetStatus
+  Image image;             // Loader thread until ASSET_DECODED
+  Texture2D texture;       // Valid once ASSET_READY
+  AssetTimings timings;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Decode assets in order on a background thread. Needs no window.
+void StartAssetLoader(TextureAsset *assets, int count);
+
+// Upload decoded assets. Returns true if any texture became ready.
+bool UpdateAssets(TextureAsset *assets, int count);
+
+// Wait for the loader thread, then free every image and texture
+void UnloadAssets(TextureAsset *assets, int count);
+
+#endif // ASSETS_H
@@ -0,0 +1,155 @@
+#include "audio.h"
+#include "raylib.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// A synthesized effect: a tone gliding from startHz to endHz as it fades out
+struct ToneShape {
+  float startHz;
+  float endHz;
+  float seconds;
+  float volume;
+  bool square; // Square wave, otherwise sine
+};
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+static const ToneShape TONES[SOUND_EFFECT_COUNT] = {
+    {660.0f, 660.0f, 0.05f, 0.25f, true},   // Brick hit: short blip
+    {880.0f, 440.0f, 0.12f, 0.30f, true},   // Brick destroyed: falling chirp
+    {220.0f, 330.0f, 0.07f, 0.50f, false},  // Paddle: soft thump
+    {523.0f, 1568.0f, 0.25f, 0.40f, false}, // Power-up: rising sweep
+    {330.0f, 55.0f, 0.60f, 0.35f, true}};   // Ball lost: long fall
+constexpr float TONE_ATTACK = 0.002f;       // Seconds, avoids a click
+
+//------------------------------------------------------------------------------------
+// Global Variables
+//------------------------------------------------------------------------------------
+static bool audioReady = false;
+static Sound voices[SOUND_EFFECT_COUNT][SOUND_VOICES] = {0};
+static int nextVoice[SOUND_EFFECT_COUNT] = {0}; // Oldest voice of each effect
+static Music music = {0};
+static bool musicLoaded = false;
+static bool musicPaused = false;
+static std::mutex musicMutex; // Music calls from both threads
+static std::thread musicThread;
+static std::atomic<bool> musicRunning(false); // Cleared to stop the thread
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void SynthesizeTone(const ToneShape &tone, std::vector<short> &samples);
+static void MusicThread();
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+bool InitGameAudio(const char *musicFileName) {
+  InitAudioDevice();
+  if (!IsAudioDeviceReady())
+    return false;
+
+  std::vector<short> samples;
+  for (int effect = 0; effect < SOUND_EFFECT_COUNT; effect++) {
+    SynthesizeTone(TONES[effect], samples);
+    const Wave wave = {static_cast<unsigned int>(samples.size()),
+                       SOUND_SAMPLE_RATE, 16, 1, samples.data()};
+    for (int voice = 0; voice < SOUND_VOICES; voice++)
+      voices[effect][voice] = LoadSoundFromWave(wave);
+  }
+  audioReady = true;
+
+  if (musicFileName == nullptr)
+    return true;
+  SetAudioStreamBufferSizeDefault(MUSIC_BUFFER_FRAMES);
+  music = LoadMusicStream(musicFileName);
+  SetAudioStreamBufferSizeDefault(0); // Back to raylib's default
+  musicLoaded = music.ctxData != nullptr;
+  if (!musicLoaded) {
+    TraceLog(LOG_WARNING, "Failed to stream music %s.", musicFileName);
+    return true;
+  }
+  music.looping = true;
+  PlayMusicStream(music);
+  musicRunning.store(true);
+  musicThread = std::thread(MusicThread);
+  TraceLog(LOG_INFO, "GAME: Streaming music from %s", musicFileName);
+  return true;
+}
+
+void CloseGameAudio() {
+  musicRunning.store(false);
+  if (musicThread.joinable())
+    musicThread.join();
+  if (musicLoaded)
+    UnloadMusicStream(music);
+  musicLoaded = false;
+  if (audioReady) {
+    for (auto &effect : voices) {
+      for (auto &voice : effect)
+        UnloadSound(voice);
+    }
+  }
+  audioReady = false;
+  if (IsAudioDeviceReady())
+    CloseAudioDevice();
+}
+
+void PlaySoundEffect(SoundEffect effect) {
+  if (!audioReady)
+    return;
+  PlaySound(voices[effect][nextVoice[effect]]); // Restarts it if still playing
+  nextVoice[effect] = (nextVoice[effect] + 1) % SOUND_VOICES;
+}
+
+void SetMusicPaused(bool paused) {
+  if (!musicLoaded || paused == musicPaused)
+    return;
+  std::lock_guard<std::mutex> lock(musicMutex);
+  if (paused)
+    PauseMusicStream(music);
+  else
+    ResumeMusicStream(music);
+  musicPaused = paused;
+}
+
+// Decay envelope over a phase-continuous glide, so the pitch sweeps smoothly
+void SynthesizeTone(const ToneShape &tone, std::vector<short> &samples) {
+  const int frames = static_cast<int>(tone.seconds * SOUND_SAMPLE_RATE);
+  samples.resize(frames);
+  float phase = 0.0f; // Cycles, 0 .. 1
+  for (int i = 0; i < frames; i++) {
+    const float t = static_cast<float>(i) / frames;
+    const float seconds = static_cast<float>(i) / SOUND_SAMPLE_RATE;
+    phase += (tone.startHz + (tone.endHz - tone.startHz) * t) /
+             SOUND_SAMPLE_RATE;
+    phase -= std::floor(phase);
+    const float wave = tone.square ? ((phase < 0.5f) ? 0.6f : -0.6f)
+                                   : std::sin(phase * 2.0f * PI);
+    const float envelope =
+        std::min(seconds / TONE_ATTACK, 1.0f) * (1.0f - t) * (1.0f - t);
+    samples[i] = static_cast<short>(wave * envelope * tone.volume * 32767.0f);
+  }
+}
+
+// UpdateMusicStream() decodes whatever part of the stream has played out
+void MusicThread() {
+  while (musicRunning.load(std::memory_order_relaxed)) {
+    {
+      std::lock_guard<std::mutex> lock(musicMutex);
+      UpdateMusicStream(music);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(MUSIC_REFILL_MS));
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+//----------------------------------------------------------------------------------
+// Sound effects and music. The effects are synthesized once at startup into a
+// fixed pool of voices each, so playing one never loads, decodes or
+// allocates; an effect with every voice busy restarts its oldest. Music is
+// streamed from a file by a background thread that keeps the stream's
+// buffers filled, so decoding never stalls a frame.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int SOUND_VOICES = 4;            // Copies of an effect playing at once
+constexpr int SOUND_SAMPLE_RATE = 22050;   // Effects are mono, 16 bit
+constexpr int MUSIC_BUFFER_FRAMES = 16384; // Stream buffer, about 0.4 s
+constexpr int MUSIC_REFILL_MS = 10;        // Refill thread period
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+enum SoundEffect {
+  SOUND_BRICK_HIT,
+  SOUND_BRICK_DESTROYED,
+  SOUND_PADDLE_HIT,
+  SOUND_POWERUP,
+  SOUND_BALL_LOST,
+  SOUND_EFFECT_COUNT
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Open the audio device, build the effect voices and start musicFileName, if
+// given, looping. Returns false without a device; the game then stays silent.
+bool InitGameAudio(const char *musicFileName);
+void CloseGameAudio();
+
+void PlaySoundEffect(SoundEffect effect);
+void SetMusicPaused(bool paused);
+
+#endif // AUDIO_H
@@ -0,0 +1,110 @@
+#include "autopilot.h"
+#include <cmath>
+#include <cstring>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct NamedController {
+  const char *name;
+  PaddleController controller;
+};
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+// Where InterceptBall strikes the ball, past the center in the direction it
+// travels. Beyond 0.3 the paddle sends the ball out at its widest angle.
+constexpr float INTERCEPT_OFFSET = 0.35f; // Of the paddle width
+
+static const NamedController CONTROLLERS[] = {{"track", TrackBall},
+                                              {"intercept", InterceptBall}};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static float PredictBallX(const Ball &ball, float y, float &speedX);
+static GameInput SteerPaddleTo(const Paddle &paddle, float x);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+GameInput TrackBall(const GameWorld &world) {
+  const Ball *target = nullptr;
+  for (const auto &ball : world.balls) {
+    if (ball.active && ball.speed.y > 0 &&
+        (target == nullptr || ball.position.y > target->position.y))
+      target = &ball;
+  }
+
+  GameInput input = {0};
+  if (target != nullptr)
+    input = SteerPaddleTo(world.paddle, target->position.x);
+  return input;
+}
+
+GameInput InterceptBall(const GameWorld &world) {
+  const Ball *target = nullptr;
+  float targetTime = 0.0f; // Seconds until target reaches the paddle
+  for (const auto &ball : world.balls) {
+    if (!ball.active || ball.speed.y <= 0)
+      continue;
+    const float time =
+        (world.paddle.rect.y - ball.radius - ball.position.y) / ball.speed.y;
+    if (target == nullptr || time < targetTime) {
+      target = &ball;
+      targetTime = time;
+    }
+  }
+
+  // Nothing falling: wait under the first ball still in play
+  if (target == nullptr) {
+    for (const auto &ball : world.balls) {
+      if (ball.active)
+        return SteerPaddleTo(world.paddle, ball.position.x);
+    }
+    return {0};
+  }
+  // Keep it going the way it came, at a wide angle, so it sweeps the wall
+  // instead of bouncing up and down one column
+  float speedX = 0.0f;
+  const float x =
+      PredictBallX(*target, world.paddle.rect.y - target->radius, speedX);
+  const float offset = INTERCEPT_OFFSET * world.paddle.rect.width;
+  return SteerPaddleTo(world.paddle, speedX > 0 ? x - offset : x + offset);
+}
+
+PaddleController FindPaddleController(const char *name) {
+  for (const auto &entry : CONTROLLERS) {
+    if (std::strcmp(entry.name, name) == 0)
+      return entry.controller;
+  }
+  return nullptr;
+}
+
+// The ball's x and horizontal speed once its center reaches y. Bouncing
+// between the side walls is a reflection, so the straight-line x is folded
+// back into the span the center can reach, reversing the speed every fold.
+float PredictBallX(const Ball &ball, float y, float &speedX) {
+  const float time = std::fmax(0.0f, (y - ball.position.y) / ball.speed.y);
+  const float span = SCREEN_WIDTH - 2.0f * ball.radius;
+  speedX = ball.speed.x;
+  if (span <= 0.0f)
+    return SCREEN_WIDTH / 2.0f;
+  float offset = std::fmod(ball.position.x + ball.speed.x * time - ball.radius,
+                           2.0f * span);
+  if (offset < 0.0f)
+    offset += 2.0f * span;
+  if (offset > span) {
+    offset = 2.0f * span - offset;
+    speedX = -speedX;
+  }
+  return ball.radius + offset;
+}
+
+// The move that centers the paddle on x within this tick, if it can
+GameInput SteerPaddleTo(const Paddle &paddle, float x) {
+  const float center = paddle.rect.x + paddle.rect.width / 2;
+  return {(x - center) / (PADDLE_SPEED * SIM_DT)};
+}
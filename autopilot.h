@@ -0,0 +1,33 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "game.h"
+
+//----------------------------------------------------------------------------------
+// Paddle controllers: steer the paddle from the world alone, in place of a
+// player at the keys. Each is a plain function of the current world with no
+// state of its own and no allocation, so any number of headless worlds can
+// be driven side by side, from any thread.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+using PaddleController = GameInput (*)(const GameWorld &world);
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Follow the lowest ball that is falling toward the paddle
+GameInput TrackBall(const GameWorld &world);
+
+// Move to where the first falling ball will reach the paddle, following its
+// bounces off the side walls. Bricks and the paddle's own speed limit are not
+// taken into account.
+GameInput InterceptBall(const GameWorld &world);
+
+// "track" or "intercept", nullptr for any other name
+PaddleController FindPaddleController(const char *name);
+
+#endif // AUTOPILOT_H
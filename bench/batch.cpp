@@ -0,0 +1,239 @@
+#include "autopilot.h"
+#include "game.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Headless batch runner for balancing: plays many independent seeded games
+// per difficulty on every core with the scripted paddle and reports win rate,
+// game length and score distributions. Each game owns its own GameWorld, so
+// workers share nothing but the task ranges and their own result slots.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int DEFAULT_GAMES = 10000;            // Games per difficulty
+constexpr unsigned int MAX_GAME_TICKS = 120000; // Give up after ~16 minutes
+constexpr int MIN_STEAL = 16; // Smallest range worth taking from a worker
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct GameOutcome {
+  bool won;
+  unsigned int ticks;
+  int score;
+};
+
+// Tasks [begin, end) still queued on one worker. The owner takes tasks from
+// the front, idle workers steal the back half.
+struct TaskRange {
+  std::mutex mutex;
+  int begin;
+  int end;
+};
+
+struct BatchJob {
+  int games; // Per difficulty; task t plays difficulty t / games
+  uint64_t seed;
+  GameTuning tuning;
+  PaddleController player;
+  std::vector<TaskRange> ranges; // One per worker
+  std::vector<GameOutcome> outcomes; // One per task
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void RunWorker(BatchJob &job, int worker);
+static bool TakeTask(TaskRange &range, int &task);
+static bool StealTasks(BatchJob &job, int thief);
+static GameOutcome PlayGame(GameWorld &world, Difficulty diff, uint64_t seed,
+                            const BatchJob &job);
+static void PrintSummary(const char *name,
+                         const std::vector<GameOutcome> &outcomes);
+static float Percentile(const std::vector<float> &sorted, float fraction);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+  int games = DEFAULT_GAMES;
+  uint64_t seed = 1;
+  int threads = static_cast<int>(std::thread::hardware_concurrency());
+  GameTuning tuning = DEFAULT_TUNING;
+  const char *playerName = "track";
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+      games = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+      threads = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--powerup-scale") == 0 && i + 1 < argc)
+      tuning.powerUpChanceScale = std::strtof(argv[++i], nullptr);
+    else if (std::strcmp(argv[i], "--paddle-scale") == 0 && i + 1 < argc)
+      tuning.paddleWidthScale = std::strtof(argv[++i], nullptr);
+    else if (std::strcmp(argv[i], "--speed-scale") == 0 && i + 1 < argc)
+      tuning.ballSpeedScale = std::strtof(argv[++i], nullptr);
+    else if (std::strcmp(argv[i], "--player") == 0 && i + 1 < argc)
+      playerName = argv[++i];
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [--games N] [--seed S] [--threads T]\n"
+                   "       [--powerup-scale X] [--paddle-scale X] "
+                   "[--speed-scale X] [--player track|intercept]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  games = std::max(games, 1);
+  threads = std::max(threads, 1);
+  const PaddleController player = FindPaddleController(playerName);
+  if (player == nullptr) {
+    std::fprintf(stderr, "Unknown player %s\n", playerName);
+    return 1;
+  }
+
+  BatchJob job;
+  job.games = games;
+  job.seed = seed;
+  job.tuning = tuning;
+  job.player = player;
+  job.outcomes.resize(DIFFICULTY_COUNT * games);
+  job.ranges = std::vector<TaskRange>(threads);
+  const int tasks = static_cast<int>(job.outcomes.size());
+  for (int worker = 0; worker < threads; worker++) {
+    job.ranges[worker].begin = tasks * worker / threads;
+    job.ranges[worker].end = tasks * (worker + 1) / threads;
+  }
+
+  std::vector<std::thread> workers;
+  for (int worker = 1; worker < threads; worker++)
+    workers.emplace_back(RunWorker, std::ref(job), worker);
+  RunWorker(job, 0);
+  for (auto &worker : workers)
+    worker.join();
+
+  std::printf("%-8s %7s %8s %9s %9s %9s %8s %8s %8s %8s\n", "level", "games",
+              "win%", "mean s", "p50 s", "p90 s", "mean sc", "p10 sc",
+              "p50 sc", "p90 sc");
+  for (int diff = 0; diff < DIFFICULTY_COUNT; diff++) {
+    const auto first = job.outcomes.begin() + diff * games;
+    PrintSummary(DIFFICULTY_CONFIGS[diff].name,
+                 std::vector<GameOutcome>(first, first + games));
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void RunWorker(BatchJob &job, int worker) {
+  // BrickStore is large, keep the world off the thread's stack
+  std::unique_ptr<GameWorld> world(new GameWorld());
+  TaskRange &range = job.ranges[worker];
+  int task = 0;
+  while (TakeTask(range, task) || (StealTasks(job, worker) &&
+                                   TakeTask(range, task))) {
+    const Difficulty diff = static_cast<Difficulty>(task / job.games);
+    const uint64_t seed = job.seed + task % job.games;
+    job.outcomes[task] = PlayGame(*world, diff, seed, job);
+  }
+}
+
+bool TakeTask(TaskRange &range, int &task) {
+  std::lock_guard<std::mutex> lock(range.mutex);
+  if (range.begin >= range.end)
+    return false;
+  task = range.begin++;
+  return true;
+}
+
+// Move the back half of the fullest other range into the thief's own, empty
+// range. Returns false once no worker has anything left to give.
+bool StealTasks(BatchJob &job, int thief) {
+  const int workers = static_cast<int>(job.ranges.size());
+  for (int attempt = 0; attempt < workers; attempt++) {
+    int victim = -1;
+    int mostLeft = 0;
+    for (int i = 0; i < workers; i++) {
+      if (i == thief)
+        continue;
+      std::lock_guard<std::mutex> lock(job.ranges[i].mutex);
+      const int left = job.ranges[i].end - job.ranges[i].begin;
+      if (left > mostLeft) {
+        victim = i;
+        mostLeft = left;
+      }
+    }
+    if (victim < 0)
+      return false;
+
+    // The victim may have drained its range since it was picked
+    int begin = 0, end = 0;
+    {
+      TaskRange &range = job.ranges[victim];
+      std::lock_guard<std::mutex> lock(range.mutex);
+      const int left = range.end - range.begin;
+      if (left <= 0)
+        continue;
+      const int taken = left < MIN_STEAL ? left : left / 2;
+      begin = range.end - taken;
+      end = range.end;
+      range.end = begin;
+    }
+    TaskRange &own = job.ranges[thief];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin;
+    own.end = end;
+    return true;
+  }
+  return false;
+}
+
+GameOutcome PlayGame(GameWorld &world, Difficulty diff, uint64_t seed,
+                     const BatchJob &job) {
+  StartGame(world, diff, seed, job.tuning);
+  while (world.status == LevelStatus::PLAYING &&
+         world.tickCount < MAX_GAME_TICKS)
+    UpdateSimulation(world, job.player(world));
+  return {world.status == LevelStatus::CLEARED, world.tickCount, world.score};
+}
+
+void PrintSummary(const char *name,
+                  const std::vector<GameOutcome> &outcomes) {
+  std::vector<float> seconds, scores;
+  int wins = 0;
+  double totalSeconds = 0.0, totalScore = 0.0;
+  for (const auto &outcome : outcomes) {
+    wins += outcome.won;
+    seconds.push_back(outcome.ticks * SIM_DT);
+    scores.push_back(static_cast<float>(outcome.score));
+    totalSeconds += seconds.back();
+    totalScore += scores.back();
+  }
+  std::sort(seconds.begin(), seconds.end());
+  std::sort(scores.begin(), scores.end());
+
+  const int games = static_cast<int>(outcomes.size());
+  std::printf("%-8s %7d %7.1f%% %9.1f %9.1f %9.1f %8.0f %8.0f %8.0f %8.0f\n",
+              name, games, 100.0 * wins / games, totalSeconds / games,
+              Percentile(seconds, 0.5f), Percentile(seconds, 0.9f),
+              totalScore / games, Percentile(scores, 0.1f),
+              Percentile(scores, 0.5f), Percentile(scores, 0.9f));
+}
+
+// Nearest-rank percentile of an ascending, non-empty list
+float Percentile(const std::vector<float> &sorted, float fraction) {
+  const size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1));
+  return sorted[rank];
+}
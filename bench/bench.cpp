@@ -0,0 +1,305 @@
+#include "autopilot.h"
+#include "game.h"
+#include "levels.h"
+#include "replay.h"
+#include "session.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Headless benchmark: plays seeded games per difficulty with a scripted
+// paddle, a recorded replay, or many sessions hosted side by side as fast as
+// possible, and reports simulation throughput. No window or GPU is opened.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int DEFAULT_GAMES = 1000;             // Games per difficulty
+constexpr unsigned int MAX_GAME_TICKS = 120000; // Give up after ~16 minutes
+constexpr int SETUP_REPEAT = 10000; // SetupLevel calls timed per wall source
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct BenchResult {
+  int games;
+  int wins;
+  uint64_t ticks;
+  uint64_t allocations;
+  SimStats stats;
+  double seconds;
+};
+
+//------------------------------------------------------------------------------------
+// Global Variables
+//------------------------------------------------------------------------------------
+static uint64_t allocationCount = 0; // Heap allocations since program start
+static PaddleController player = TrackBall; // --player
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static BenchResult RunDifficulty(Difficulty diff, int games, uint64_t seed,
+                                 const LevelPack *pack, int rows, int cols);
+static double TimeLevelSetup(const LevelPack *pack, uint64_t seed);
+static BenchResult RunReplay(const Replay &replay, int repeat);
+static BenchResult RunSessions(int count, uint64_t seed, size_t &bytes);
+static uint8_t GetSessionInput(const GameSession &session);
+static void PrintResult(const char *name, const BenchResult &result);
+
+//------------------------------------------------------------------------------------
+// Allocation counting
+//------------------------------------------------------------------------------------
+void *operator new(std::size_t size) {
+  allocationCount++;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+  int games = DEFAULT_GAMES;
+  uint64_t seed = 1;
+  const char *replayFileName = nullptr;
+  int sessions = 0;
+  const char *packFileName = nullptr;
+  int wallRows = 0, wallCols = 0;
+  const char *playerName = "track";
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+      games = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+      replayFileName = argv[++i];
+    else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc)
+      sessions = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+      packFileName = argv[++i];
+    else if (std::strcmp(argv[i], "--wall") == 0 && i + 1 < argc)
+      std::sscanf(argv[++i], "%dx%d", &wallRows, &wallCols);
+    else if (std::strcmp(argv[i], "--player") == 0 && i + 1 < argc)
+      playerName = argv[++i];
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [--games N] [--seed S] [--replay FILE] "
+                   "[--sessions N] [--pack FILE] [--wall ROWSxCOLS]\n"
+                   "       [--player track|intercept]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  if (wallRows < 0 || wallRows > MAX_GRID_ROWS || wallCols < 0 ||
+      wallCols > MAX_GRID_COLS) {
+    std::fprintf(stderr, "--wall is limited to %dx%d\n", MAX_GRID_ROWS,
+                 MAX_GRID_COLS);
+    return 1;
+  }
+  player = FindPaddleController(playerName);
+  if (player == nullptr) {
+    std::fprintf(stderr, "Unknown player %s\n", playerName);
+    return 1;
+  }
+
+  std::printf("%-8s %7s %6s %12s %12s %10s %10s %10s\n", "level", "games",
+              "wins", "ticks", "ticks/sec", "cells/tk", "sweeps/tk",
+              "allocs/tk");
+  if (replayFileName != nullptr) {
+    static Replay replay;
+    if (!LoadReplay(replay, replayFileName)) {
+      std::fprintf(stderr, "Failed to load replay %s\n", replayFileName);
+      return 1;
+    }
+    if (replay.packHash != 0) {
+      std::fprintf(stderr, "Replay %s needs a level pack\n", replayFileName);
+      return 1;
+    }
+    // --games sets how many times the replay is repeated
+    PrintResult("REPLAY", RunReplay(replay, games));
+    return 0;
+  }
+  if (sessions > 0) {
+    size_t bytes = 0;
+    PrintResult("SESSIONS", RunSessions(sessions, seed, bytes));
+    std::printf("session memory: %zu bytes each, %zu inline\n", bytes,
+                sizeof(GameSession));
+    return 0;
+  }
+
+  // --pack plays its levels instead of generated walls
+  static LevelPack pack;
+  const LevelPack *levels = nullptr;
+  if (packFileName != nullptr) {
+    if (!OpenLevelPack(pack, packFileName, MAX_GRID_ROWS, MAX_GRID_COLS)) {
+      std::fprintf(stderr, "Failed to open level pack %s\n", packFileName);
+      return 1;
+    }
+    levels = &pack;
+  }
+  PrintResult("EASY", RunDifficulty(Difficulty::EASY, games, seed, levels,
+                                    wallRows, wallCols));
+  PrintResult("MEDIUM", RunDifficulty(Difficulty::MEDIUM, games, seed, levels,
+                                      wallRows, wallCols));
+  PrintResult("HARD", RunDifficulty(Difficulty::HARD, games, seed, levels,
+                                    wallRows, wallCols));
+  if (levels != nullptr) {
+    std::printf("level setup: %.2f us generated, %.2f us from the pack\n",
+                TimeLevelSetup(nullptr, seed), TimeLevelSetup(levels, seed));
+    CloseLevelPack(pack);
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+// Play `games` seeded games of one difficulty and accumulate their counters.
+// rows and cols size the generated walls, 0 for the classic grid.
+BenchResult RunDifficulty(Difficulty diff, int games, uint64_t seed,
+                          const LevelPack *pack, int rows, int cols) {
+  BenchResult result = {0};
+  static GameWorld world;
+  world.levelPack = pack;
+  world.wallRows = rows;
+  world.wallCols = cols;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int game = 0; game < games; game++) {
+    StartGame(world, diff, seed + game);
+
+    const uint64_t allocationsBefore = allocationCount;
+    while (world.status == LevelStatus::PLAYING &&
+           world.tickCount < MAX_GAME_TICKS)
+      UpdateSimulation(world, player(world));
+    result.allocations += allocationCount - allocationsBefore;
+
+    result.games++;
+    result.wins += world.status == LevelStatus::CLEARED;
+    result.ticks += world.tickCount;
+    result.stats.broadphaseTests += world.stats.broadphaseTests;
+    result.stats.sweepTests += world.stats.sweepTests;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+// Mean microseconds per SetupLevel, cycling through the pack's levels or
+// the generated difficulties
+double TimeLevelSetup(const LevelPack *pack, uint64_t seed) {
+  static GameWorld world;
+  world.levelPack = pack;
+  StartGame(world, Difficulty::EASY, seed);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SETUP_REPEAT; i++) {
+    world.packLevel = pack != nullptr ? i % pack->levelCount : 0;
+    SetupLevel(world, static_cast<Difficulty>(i % 3));
+  }
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         SETUP_REPEAT;
+}
+
+// Play a replay `repeat` times back to back. Every run must end identically.
+BenchResult RunReplay(const Replay &replay, int repeat) {
+  BenchResult result = {0};
+  static GameWorld world;
+  ReplayCursor cursor = {0};
+  int firstScore = -1;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int run = 0; run < repeat; run++) {
+    StartReplay(world, replay, cursor);
+    const uint64_t allocationsBefore = allocationCount;
+    while (StepReplay(world, replay, cursor)) {
+    }
+    result.allocations += allocationCount - allocationsBefore;
+
+    if (firstScore < 0)
+      firstScore = world.score;
+    else if (world.score != firstScore)
+      std::fprintf(stderr, "Replay run %d diverged: score %d, expected %d\n",
+                   run, world.score, firstScore);
+    result.games++;
+    result.wins += world.status == LevelStatus::CLEARED;
+    result.ticks += world.tickCount;
+    result.stats.broadphaseTests += world.stats.broadphaseTests;
+    result.stats.sweepTests += world.stats.sweepTests;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+// Host `count` sessions of mixed difficulty in one process and step them
+// round-robin, one tick each, until every game is over. bytes receives the
+// average memory per session.
+BenchResult RunSessions(int count, uint64_t seed, size_t &bytes) {
+  BenchResult result = {0};
+  std::vector<GameSession> sessions(count);
+  for (int i = 0; i < count; i++)
+    StartSession(sessions[i], static_cast<Difficulty>(i % 3), seed + i, false);
+
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t allocationsBefore = allocationCount;
+  for (int playing = count; playing > 0;) {
+    playing = 0;
+    for (auto &session : sessions) {
+      if (session.state != GameState::PLAYING ||
+          session.world.tickCount >= MAX_GAME_TICKS)
+        continue;
+      StepSession(session, GetSessionInput(session));
+      playing++;
+    }
+  }
+  result.allocations = allocationCount - allocationsBefore;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  bytes = 0;
+  for (const auto &session : sessions) {
+    result.games++;
+    result.wins += session.state == GameState::YOU_WIN;
+    result.ticks += session.world.tickCount;
+    result.stats.broadphaseTests += session.world.stats.broadphaseTests;
+    result.stats.sweepTests += session.world.stats.sweepTests;
+    bytes += GetSessionMemoryUsage(session);
+  }
+  bytes /= sessions.size();
+  return result;
+}
+
+// The scripted player as the arrow keys a session takes
+uint8_t GetSessionInput(const GameSession &session) {
+  const float move = player(session.world).paddleMove;
+  return move <= -1.0f ? REPLAY_LEFT : move >= 1.0f ? REPLAY_RIGHT : 0;
+}
+
+void PrintResult(const char *name, const BenchResult &result) {
+  const double ticks = result.ticks > 0 ? static_cast<double>(result.ticks) : 1;
+  std::printf("%-8s %7d %6d %12llu %12.0f %10.2f %10.2f %10.4f\n", name,
+              result.games, result.wins,
+              static_cast<unsigned long long>(result.ticks),
+              result.seconds > 0 ? result.ticks / result.seconds : 0.0,
+              result.stats.broadphaseTests / ticks,
+              result.stats.sweepTests / ticks, result.allocations / ticks);
+}
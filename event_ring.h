@@ -0,0 +1,53 @@
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Lock-free queue from one producer thread to one consumer thread. Unlike a
+// TripleBuffer nothing is overwritten: every value pushed is popped once, in
+// order, unless the ring was full, in which case the value is counted as
+// dropped and the producer carries on without waiting.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+template <typename T, int N> struct EventRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of 2");
+
+  T slots[N];
+  std::atomic<unsigned int> head{0};    // Next slot to write, producer only
+  std::atomic<unsigned int> tail{0};    // Next slot to read, consumer only
+  std::atomic<unsigned int> dropped{0}; // Pushes refused while full
+
+  bool Push(const T &value) {
+    const unsigned int position = head.load(std::memory_order_relaxed);
+    if (position - tail.load(std::memory_order_acquire) == N) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots[position % N] = value;
+    head.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Oldest value without taking it, nullptr while empty. Consumer only.
+  const T *Front() const {
+    const unsigned int position = tail.load(std::memory_order_relaxed);
+    if (position == head.load(std::memory_order_acquire))
+      return nullptr;
+    return &slots[position % N];
+  }
+
+  bool Pop(T &value) {
+    const unsigned int position = tail.load(std::memory_order_relaxed);
+    if (position == head.load(std::memory_order_acquire))
+      return false;
+    value = slots[position % N];
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+#endif // EVENT_RING_H
@@ -0,0 +1,1144 @@
+#include "game.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BRICKS_USE_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BRICKS_USE_NEON
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Result of sweeping a circle against a rectangle
+struct SweepHit {
+  float time;      // Fraction of the sweep at first contact (0 if overlapping)
+  Vector2 normal;  // Surface normal at the contact, pointing toward the ball
+  Vector2 contact; // Ball center at first contact, just touching the surface
+};
+
+// Grid shape for the passes that walk the wall: compile-time constants for
+// the classic grid, so its loops and cell math are specialized, or the
+// store's own dimensions
+struct ClassicGrid {
+  explicit ClassicGrid(const BrickStore &) {}
+  int rows() const { return BRICK_ROWS; }
+  int cols() const { return BRICKS_PER_ROW; }
+  float cellWidth() const { return BRICK_WIDTH; }
+  float cellHeight() const { return BRICK_HEIGHT; }
+};
+
+struct RuntimeGrid {
+  const BrickStore &bricks;
+  explicit RuntimeGrid(const BrickStore &bricks) : bricks(bricks) {}
+  int rows() const { return bricks.rows; }
+  int cols() const { return bricks.cols; }
+  float cellWidth() const { return bricks.cellWidth; }
+  float cellHeight() const { return bricks.cellHeight; }
+};
+
+// How a level's sliding bricks are moved each tick
+enum class MoverPass {
+  NONE,    // The level has none
+  CLASSIC, // Vectorized sweep over the whole classic grid
+  LISTED   // Only world.movingBricks
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void GenerateBricks(GameWorld &world, const DifficultyConfig &config);
+static void PlacePackBricks(GameWorld &world, const LevelPackEntry &entry,
+                            const uint8_t *cells);
+static int FindPackLevel(const LevelPack &pack, Difficulty diff);
+static void SpawnPowerUp(GameWorld &world, Vector2 position);
+static void UpdatePowerUps(GameWorld &world);
+static void ApplyPowerUp(GameWorld &world, PowerUpType type);
+static void PushGameEvent(GameWorld &world, GameEventType type,
+                          Vector2 position, int brick = 0,
+                          PowerUpType powerUp = PowerUpType::NONE);
+static void ApplyGameEvents(GameWorld &world, int first);
+static void ApplyGameEvent(GameWorld &world, const GameEvent &event);
+static void MoveBall(GameWorld &world, Ball &ball);
+static bool SweepCircleRec(Vector2 center, Vector2 delta, float radius,
+                           Rectangle rec, SweepHit &hit);
+static int FindBrickHit(GameWorld &world, const Ball &ball, Vector2 delta,
+                        SweepHit &hit);
+template <typename Grid>
+static int FindGridBrickHit(GameWorld &world, const Ball &ball, Vector2 delta,
+                            SweepHit &hit);
+static void HandleBrickCollision(GameWorld &world, Ball &ball, int brick,
+                                 const SweepHit &hit);
+static void HandlePaddleCollision(GameWorld &world, Ball &ball);
+static unsigned int ActiveBrickBits(const BrickStore &bricks, int first,
+                                    int count);
+static unsigned int CircleRecMask(const BrickStore &bricks, Vector2 center,
+                                  float radius, int first);
+template <MoverPass movers>
+static void StepWorld(GameWorld &world, const GameInput &input);
+static void MoveListedBricks(GameWorld &world);
+static void MoveClassicBricks(BrickStore &bricks);
+static bool RecsOverlap(Rectangle a, Rectangle b);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void StartGame(GameWorld &world, Difficulty diff, uint64_t seed,
+               const GameTuning &tuning) {
+  world.tuning = tuning;
+  world.score = 0;
+  world.lives = 3;
+  world.tickCount = 0;
+  world.stats = {0};
+  world.powerUps.clear();
+  world.balls.clear();
+  world.seed = seed;
+  world.level = 1;
+  if (world.levelPack != nullptr)
+    world.packLevel = FindPackLevel(*world.levelPack, diff);
+  SeedRng(world.rng, seed);
+  SetupLevel(world, diff);
+}
+
+// Levels of a pack play by the rules of their own difficulty instead of diff
+void SetupLevel(GameWorld &world, Difficulty diff) {
+  const bool fromPack = world.levelPack != nullptr &&
+                        world.packLevel < world.levelPack->levelCount;
+  const LevelPackEntry *entry =
+      fromPack ? &world.levelPack->entries[world.packLevel] : nullptr;
+  if (fromPack)
+    diff = static_cast<Difficulty>(entry->difficulty);
+
+  const DifficultyConfig &config = GetDifficultyConfig(diff);
+  world.difficulty = diff;
+  world.status = LevelStatus::PLAYING;
+  world.powerUpSpawnChance =
+      config.powerUpSpawnChance * world.tuning.powerUpChanceScale;
+  world.paddle.rect.width = config.paddleWidth * world.tuning.paddleWidthScale;
+  world.paddle.rect.height = PADDLE_HEIGHT;
+  world.paddle.rect.x = (SCREEN_WIDTH - world.paddle.rect.width) / 2.0f;
+  world.paddle.rect.y = SCREEN_HEIGHT - world.paddle.rect.height - 30.0f;
+  world.paddle.color = LIGHTGRAY; // Changed to LIGHTGRAY
+
+  ResetBallsAndPaddle(world);
+
+  world.movingBricks.clear();
+  if (fromPack)
+    InitBrickGrid(world.bricks, entry->rows, entry->cols);
+  else if (world.wallRows > 0 && world.wallCols > 0)
+    InitBrickGrid(world.bricks, world.wallRows, world.wallCols);
+  else
+    InitBrickGrid(world.bricks, BRICK_ROWS, BRICKS_PER_ROW);
+  if (fromPack)
+    PlacePackBricks(world, *entry,
+                    GetLevelCells(*world.levelPack, world.packLevel));
+  else
+    GenerateBricks(world, config);
+  world.wallVersion++;
+  world.brickVersion++;
+
+  // Most levels have no moving bricks, their tick does not contain the pass
+  if (world.movingBricks.empty())
+    world.step = StepWorld<MoverPass::NONE>;
+  else if (IsClassicGrid(world.bricks))
+    world.step = StepWorld<MoverPass::CLASSIC>;
+  else
+    world.step = StepWorld<MoverPass::LISTED>;
+
+  world.countdownTimer = config.timeLimit;
+  if (fromPack && entry->timeLimit > 0)
+    world.countdownTimer = entry->timeLimit;
+}
+
+// Random wall: a shuffled 70-90% of the rows config does not leave empty.
+// Draws only what config varies, so a fixed hit count costs no random number.
+void GenerateBricks(GameWorld &world, const DifficultyConfig &config) {
+  const int rows = world.bricks.rows;
+  const int activeRows =
+      rows - (config.emptyRowsDivisor > 0 ? rows / config.emptyRowsDivisor : 0);
+
+  std::vector<std::pair<int, int>> positions;
+  for (int i = 0; i < activeRows; i++)
+    for (int j = 0; j < world.bricks.cols; j++)
+      positions.emplace_back(i, j);
+
+  // Fisher-Yates with the world stream; std::shuffle's draws vary by library
+  for (int k = static_cast<int>(positions.size()) - 1; k > 0; k--)
+    std::swap(positions[k], positions[RandomRange(world.rng, 0, k)]);
+  const int maxBricks = positions.size();
+  const int numBricks =
+      maxBricks * (RandomRange(world.rng, 70, 90) / 100.0f);
+
+  for (int k = 0; k < numBricks && k < static_cast<int>(positions.size());
+       k++) {
+    const int i = positions[k].first;
+    const int index = i * world.bricks.cols + positions[k].second;
+    SetBrickActive(world.bricks, index, true);
+    world.bricks.hitsRequired[index] =
+        (config.maxHits > 1) ? RandomRange(world.rng, 1, config.maxHits) : 1;
+    world.bricks.moveSpeed[index] =
+        (config.movingBrickChance > 0 && i == activeRows - 1 &&
+         RandomRange(world.rng, 0, 100) < config.movingBrickChance)
+            ? MOVING_BRICK_SPEED
+            : 0.0f;
+    if (world.bricks.moveSpeed[index] != 0.0f)
+      world.movingBricks.push_back(index);
+    world.bricks.color[index] = GetBrickColor(world.bricks.hitsRequired[index]);
+  }
+}
+
+// Copy a designed level's cells into a wall of the level's own size
+void PlacePackBricks(GameWorld &world, const LevelPackEntry &entry,
+                     const uint8_t *cells) {
+  for (int i = 0; i < entry.rows; i++) {
+    for (int j = 0; j < entry.cols; j++) {
+      const int index = i * entry.cols + j;
+      const uint8_t cell = cells[index];
+      const int hits = cell & LEVEL_CELL_HITS;
+      if (hits == 0)
+        continue;
+      SetBrickActive(world.bricks, index, true);
+      world.bricks.hitsRequired[index] = hits;
+      if (cell & LEVEL_CELL_MOVING) {
+        world.bricks.moveSpeed[index] = MOVING_BRICK_SPEED;
+        world.movingBricks.push_back(index);
+      }
+      world.bricks.color[index] = GetBrickColor(hits);
+    }
+  }
+}
+
+// First level of difficulty diff or harder, the first of all if none is
+int FindPackLevel(const LevelPack &pack, Difficulty diff) {
+  for (int level = 0; level < pack.levelCount; level++)
+    if (pack.entries[level].difficulty >= static_cast<int>(diff))
+      return level;
+  return 0;
+}
+
+// Set up the next level after a cleared one, keeping score, lives and the
+// random stream: the next pack entry, or the next harder generated wall.
+// Returns false when the game has no further level.
+bool AdvanceLevel(GameWorld &world) {
+  if (!HasNextLevel(world))
+    return false;
+  if (world.levelPack != nullptr) {
+    world.packLevel++;
+    SetupLevel(world, world.difficulty);
+  } else {
+    SetupLevel(world, static_cast<Difficulty>(
+                          static_cast<int>(world.difficulty) + 1));
+  }
+  world.score += 100;
+  world.level++;
+  return true;
+}
+
+bool HasNextLevel(const GameWorld &world) {
+  if (world.levelPack != nullptr)
+    return world.packLevel + 1 < world.levelPack->levelCount;
+  return static_cast<int>(world.difficulty) + 1 < DIFFICULTY_COUNT;
+}
+
+void ResetBallsAndPaddle(GameWorld &world) {
+  world.paddle.rect.x = (SCREEN_WIDTH - world.paddle.rect.width) / 2.0f;
+  world.paddle.rect.y = SCREEN_HEIGHT - world.paddle.rect.height - 30.0f;
+  world.paddle.prevX = world.paddle.rect.x;
+
+  world.balls.clear();
+  Ball newBall = {0};
+  newBall.position = {world.paddle.rect.x + world.paddle.rect.width / 2.0f,
+                      world.paddle.rect.y - BALL_RADIUS - 5.0f};
+  newBall.prevPosition = newBall.position;
+  newBall.radius = BALL_RADIUS;
+  newBall.color = WHITE;
+  const float speedScale =
+      GetDifficultyConfig(world.difficulty).ballSpeedScale;
+  newBall.speed.x = INITIAL_BALL_SPEED_X * speedScale *
+                    (RandomRange(world.rng, 0, 1) ? 1.0f : -1.0f);
+  newBall.speed.y = INITIAL_BALL_SPEED_Y * speedScale;
+  newBall.speed.x *= world.tuning.ballSpeedScale;
+  newBall.speed.y *= world.tuning.ballSpeedScale;
+  newBall.active = true;
+  world.balls.push_back(newBall);
+}
+
+void SpawnPowerUp(GameWorld &world, Vector2 position) {
+  if (RandomRange(world.rng, 0, 100) / 100.0f > world.powerUpSpawnChance)
+    return;
+
+  PowerUp powerUp = {0};
+  powerUp.rect = {position.x, position.y, POWERUP_SIZE, POWERUP_SIZE};
+  powerUp.prevY = powerUp.rect.y;
+  powerUp.active = true;
+
+  const int type = RandomRange(world.rng, 1, 4);
+  powerUp.type = static_cast<PowerUpType>(type);
+  powerUp.color = GetPowerUpColor(powerUp.type);
+
+  if (world.powerUps.push_back(powerUp))
+    PushGameEvent(world, GameEventType::POWERUP_SPAWNED, position, 0,
+                  powerUp.type);
+}
+
+int SpawnStressLoad(GameWorld &world, int balls, int powerUps) {
+  const int top = static_cast<int>(
+      BRICK_OFFSET_Y + world.bricks.rows * world.bricks.cellHeight);
+  const int bottom = static_cast<int>(world.paddle.rect.y) - 100;
+  const int radius = static_cast<int>(BALL_RADIUS);
+  const int size = static_cast<int>(POWERUP_SIZE);
+  const float speedScale =
+      GetDifficultyConfig(world.difficulty).ballSpeedScale;
+
+  Ball ball = {0};
+  ball.radius = BALL_RADIUS;
+  ball.color = WHITE;
+  ball.active = true;
+  while (world.balls.size() < balls && !world.balls.full()) {
+    ball.position = {
+        static_cast<float>(
+            RandomRange(world.rng, radius, SCREEN_WIDTH - radius)),
+        static_cast<float>(RandomRange(world.rng, top, bottom))};
+    ball.prevPosition = ball.position;
+    ball.speed.x = INITIAL_BALL_SPEED_X * speedScale *
+                   (RandomRange(world.rng, 0, 1) ? 1.0f : -1.0f);
+    ball.speed.y = INITIAL_BALL_SPEED_Y * speedScale;
+    world.balls.push_back(ball);
+  }
+
+  PowerUp powerUp = {0};
+  powerUp.active = true;
+  powerUp.type = PowerUpType::MULTI_BALL;
+  powerUp.color = GetPowerUpColor(powerUp.type);
+  while (world.powerUps.size() < powerUps && !world.powerUps.full()) {
+    powerUp.rect = {
+        static_cast<float>(RandomRange(world.rng, 0, SCREEN_WIDTH - size)),
+        static_cast<float>(RandomRange(world.rng, top, bottom)), POWERUP_SIZE,
+        POWERUP_SIZE};
+    powerUp.prevY = powerUp.rect.y;
+    world.powerUps.push_back(powerUp);
+  }
+  return std::max(0, balls - world.balls.size()) +
+         std::max(0, powerUps - world.powerUps.size());
+}
+
+// Pickups take effect once every power-up has moved
+void UpdatePowerUps(GameWorld &world) {
+  const int firstEvent = world.events.size();
+  for (int i = 0; i < world.powerUps.size();) {
+    PowerUp &powerUp = world.powerUps[i];
+    powerUp.prevY = powerUp.rect.y;
+    powerUp.rect.y += POWERUP_SPEED * SIM_DT;
+
+    if (RecsOverlap(powerUp.rect, world.paddle.rect)) {
+      PushGameEvent(world, GameEventType::POWERUP_COLLECTED,
+                    {powerUp.rect.x, powerUp.rect.y}, 0, powerUp.type);
+      powerUp.active = false;
+    } else if (powerUp.rect.y > SCREEN_HEIGHT) {
+      powerUp.active = false;
+    }
+
+    if (powerUp.active)
+      ++i;
+    else
+      world.powerUps.remove(i);
+  }
+  ApplyGameEvents(world, firstEvent);
+}
+
+void ApplyPowerUp(GameWorld &world, PowerUpType type) {
+  switch (type) {
+  case PowerUpType::PADDLE_SIZE_UP:
+    world.paddle.rect.width =
+        std::min(world.paddle.rect.width * 1.2f, PADDLE_WIDTH * 2.0f);
+    world.paddle.rect.x =
+        std::max(0.0f, std::min(world.paddle.rect.x,
+                                static_cast<float>(SCREEN_WIDTH) -
+                                    world.paddle.rect.width));
+    break;
+  case PowerUpType::BALL_SPEED_UP:
+    for (auto &ball : world.balls) {
+      ball.speed.x *= 1.2f;
+      ball.speed.y *= 1.2f;
+      if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
+        ball.speed.x =
+            (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
+      }
+    }
+    break;
+  case PowerUpType::EXTRA_LIFE:
+    world.lives++;
+    break;
+  case PowerUpType::MULTI_BALL:
+    for (int i = 0; i < 2 && !world.balls.empty(); i++) {
+      Ball newBall = world.balls[0];
+      newBall.speed.x *= (i == 0 ? -1.0f : 1.0f);
+      newBall.speed.y = -std::abs(newBall.speed.y);
+      newBall.active = true;
+      world.balls.push_back(newBall);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// GAME_EVENT_CAPACITY covers the worst tick at the default pool sizes. Past
+// it the event's rules are applied at once, as ApplyGameEvents() would have,
+// and only presentation misses it.
+void PushGameEvent(GameWorld &world, GameEventType type, Vector2 position,
+                   int brick, PowerUpType powerUp) {
+  GameEvent event = {type};
+  event.powerUp = static_cast<uint8_t>(powerUp);
+  event.brick = static_cast<uint16_t>(brick);
+  event.position = position;
+  if (world.events.full()) {
+    world.stats.droppedEvents++;
+    ApplyGameEvent(world, event);
+    return;
+  }
+  world.events.push_back(event);
+}
+
+// The game rules' side of the events raised since first: score, the wall's
+// bookkeeping and power-ups. Spawns append events of their own, which have
+// nothing to apply.
+void ApplyGameEvents(GameWorld &world, int first) {
+  for (int i = first; i < world.events.size(); i++)
+    ApplyGameEvent(world, world.events[i]);
+}
+
+void ApplyGameEvent(GameWorld &world, const GameEvent &event) {
+  BrickStore &bricks = world.bricks;
+  switch (event.type) {
+  case GameEventType::BRICK_HIT:
+    if (bricks.hitsRequired[event.brick] > 0) {
+      bricks.color[event.brick] =
+          GetBrickColor(bricks.hitsRequired[event.brick]);
+    }
+    break;
+  case GameEventType::BRICK_DESTROYED:
+    world.score += 10;
+    SpawnPowerUp(world, event.position);
+    break;
+  case GameEventType::POWERUP_COLLECTED:
+    ApplyPowerUp(world, static_cast<PowerUpType>(event.powerUp));
+    break;
+  default:
+    break;
+  }
+}
+
+// Sweep a circle moving by delta against a rectangle and report the first
+// contact. A circle that already overlaps reports a hit at time 0 with the
+// normal pointing out of the rectangle.
+bool SweepCircleRec(Vector2 center, Vector2 delta, float radius,
+                    Rectangle rec, SweepHit &hit) {
+  const float left = rec.x;
+  const float right = rec.x + rec.width;
+  const float top = rec.y;
+  const float bottom = rec.y + rec.height;
+
+  // Resting overlap: push out along the closest feature
+  const float closestX = std::max(left, std::min(center.x, right));
+  const float closestY = std::max(top, std::min(center.y, bottom));
+  const float offsetX = center.x - closestX;
+  const float offsetY = center.y - closestY;
+  const float distanceSq = offsetX * offsetX + offsetY * offsetY;
+  if (distanceSq < radius * radius) {
+    hit.time = 0.0f;
+    if (distanceSq > 0.0f) {
+      const float distance = std::sqrt(distanceSq);
+      hit.normal = {offsetX / distance, offsetY / distance};
+      hit.contact = {closestX + hit.normal.x * radius,
+                     closestY + hit.normal.y * radius};
+    } else {
+      // Center is inside the rectangle: leave through the nearest side
+      const float toLeft = center.x - left;
+      const float toRight = right - center.x;
+      const float toTop = center.y - top;
+      const float toBottom = bottom - center.y;
+      const float nearest = std::min({toLeft, toRight, toTop, toBottom});
+      hit.contact = center;
+      if (nearest == toLeft) {
+        hit.normal = {-1.0f, 0.0f};
+        hit.contact.x = left - radius;
+      } else if (nearest == toRight) {
+        hit.normal = {1.0f, 0.0f};
+        hit.contact.x = right + radius;
+      } else if (nearest == toTop) {
+        hit.normal = {0.0f, -1.0f};
+        hit.contact.y = top - radius;
+      } else {
+        hit.normal = {0.0f, 1.0f};
+        hit.contact.y = bottom + radius;
+      }
+    }
+    return true;
+  }
+
+  // Ray against the rectangle expanded by the radius (slab test)
+  float tEnter = -INFINITY;
+  float tExit = INFINITY;
+  Vector2 normal = {0.0f, 0.0f};
+  if (delta.x != 0.0f) {
+    float t1 = (left - radius - center.x) / delta.x;
+    float t2 = (right + radius - center.x) / delta.x;
+    if (t1 > t2)
+      std::swap(t1, t2);
+    if (t1 > tEnter) {
+      tEnter = t1;
+      normal = {delta.x > 0.0f ? -1.0f : 1.0f, 0.0f};
+    }
+    tExit = std::min(tExit, t2);
+  } else if (center.x < left - radius || center.x > right + radius) {
+    return false;
+  }
+  if (delta.y != 0.0f) {
+    float t1 = (top - radius - center.y) / delta.y;
+    float t2 = (bottom + radius - center.y) / delta.y;
+    if (t1 > t2)
+      std::swap(t1, t2);
+    if (t1 > tEnter) {
+      tEnter = t1;
+      normal = {0.0f, delta.y > 0.0f ? -1.0f : 1.0f};
+    }
+    tExit = std::min(tExit, t2);
+  } else if (center.y < top - radius || center.y > bottom + radius) {
+    return false;
+  }
+  if (tEnter > tExit || tEnter > 1.0f || tExit < 0.0f)
+    return false;
+  tEnter = std::max(tEnter, 0.0f);
+
+  const Vector2 entry = {center.x + delta.x * tEnter,
+                         center.y + delta.y * tEnter};
+  const bool outsideX = entry.x < left || entry.x > right;
+  const bool outsideY = entry.y < top || entry.y > bottom;
+  if (outsideX && outsideY) {
+    // Entered through a rounded corner: intersect with the corner circle
+    const Vector2 corner = {entry.x < left ? left : right,
+                            entry.y < top ? top : bottom};
+    const float mx = center.x - corner.x;
+    const float my = center.y - corner.y;
+    const float a = delta.x * delta.x + delta.y * delta.y;
+    const float b = mx * delta.x + my * delta.y;
+    const float c = mx * mx + my * my - radius * radius;
+    const float discriminant = b * b - a * c;
+    if (a == 0.0f || discriminant < 0.0f)
+      return false;
+    const float t = (-b - std::sqrt(discriminant)) / a;
+    if (t < 0.0f || t > 1.0f)
+      return false;
+    hit.time = t;
+    hit.contact = {center.x + delta.x * t, center.y + delta.y * t};
+    hit.normal = {(hit.contact.x - corner.x) / radius,
+                  (hit.contact.y - corner.y) / radius};
+  } else {
+    hit.time = tEnter;
+    hit.contact = entry;
+    hit.normal = normal;
+  }
+
+  // Ignore surfaces the ball is moving away from
+  return delta.x * hit.normal.x + delta.y * hit.normal.y < 0.0f;
+}
+
+// Find the earliest brick the ball touches while moving by delta.
+// Returns the brick index, or -1 when the path is clear.
+int FindBrickHit(GameWorld &world, const Ball &ball, Vector2 delta,
+                 SweepHit &hit) {
+  if (IsClassicGrid(world.bricks))
+    return FindGridBrickHit<ClassicGrid>(world, ball, delta, hit);
+  return FindGridBrickHit<RuntimeGrid>(world, ball, delta, hit);
+}
+
+template <typename Grid>
+int FindGridBrickHit(GameWorld &world, const Ball &ball, Vector2 delta,
+                     SweepHit &hit) {
+  const Grid grid(world.bricks);
+  int hitBrick = -1;
+  hit.time = INFINITY;
+  SweepHit candidate = {0};
+
+  // Broadphase: a static brick lies inside its own grid cell, so only the
+  // cells covered by the swept bounding box can contain a hit
+  const float minX = std::min(ball.position.x, ball.position.x + delta.x);
+  const float maxX = std::max(ball.position.x, ball.position.x + delta.x);
+  const float minY = std::min(ball.position.y, ball.position.y + delta.y);
+  const float maxY = std::max(ball.position.y, ball.position.y + delta.y);
+  const int firstRow = std::max(
+      0, static_cast<int>(std::floor((minY - ball.radius - BRICK_OFFSET_Y) /
+                                     grid.cellHeight())));
+  const int lastRow = std::min(
+      grid.rows() - 1, static_cast<int>(std::floor(
+                           (maxY + ball.radius - BRICK_OFFSET_Y) /
+                           grid.cellHeight())));
+  const int firstCol = std::max(
+      0, static_cast<int>(std::floor((minX - ball.radius) / grid.cellWidth())));
+  const int lastCol = std::min(
+      grid.cols() - 1,
+      static_cast<int>(std::floor((maxX + ball.radius) / grid.cellWidth())));
+
+  // The circle around the swept path bounds every position of the ball this
+  // sweep, so bricks it misses cannot be hit and skip the exact test
+  const Vector2 pathCenter = {ball.position.x + delta.x * 0.5f,
+                              ball.position.y + delta.y * 0.5f};
+  const float pathRadius =
+      ball.radius + 0.5f * std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+  for (int i = firstRow; i <= lastRow; i++) {
+    if (world.bricks.rowActive[i] == 0)
+      continue; // Cleared rows cost one test
+    for (int j = firstCol; j <= lastCol; j += BRICK_LANES) {
+      const int first = i * grid.cols() + j;
+      const int lanes = std::min(BRICK_LANES, lastCol - j + 1);
+      world.stats.broadphaseTests += lanes;
+      unsigned int candidates = ActiveBrickBits(world.bricks, first, lanes);
+      if (candidates == 0)
+        continue;
+      candidates &= CircleRecMask(world.bricks, pathCenter, pathRadius, first);
+      while (candidates != 0) {
+        const int brick = first + __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        if (world.bricks.moveSpeed[brick] != 0.0f)
+          continue;
+        world.stats.sweepTests++;
+        if (SweepCircleRec(ball.position, delta, ball.radius,
+                           GetBrickRect(world.bricks, brick), candidate) &&
+            candidate.time < hit.time) {
+          hit = candidate;
+          hitBrick = brick;
+        }
+      }
+    }
+  }
+
+  // Moving bricks drift out of their cells and are tested individually
+  for (const int brick : world.movingBricks) {
+    if (!IsBrickActive(world.bricks, brick))
+      continue;
+    world.stats.sweepTests++;
+    if (SweepCircleRec(ball.position, delta, ball.radius,
+                       GetBrickRect(world.bricks, brick), candidate) &&
+        candidate.time < hit.time) {
+      hit = candidate;
+      hitBrick = brick;
+    }
+  }
+  return hitBrick;
+}
+
+// Apply a hit to a brick and reflect the ball off the contact surface
+// Only what later contacts of this tick depend on changes here, the rest is
+// applied from the event by ApplyGameEvents()
+void HandleBrickCollision(GameWorld &world, Ball &ball, int brick,
+                          const SweepHit &hit) {
+  BrickStore &bricks = world.bricks;
+  bricks.hitsRequired[brick]--;
+  if (bricks.moveSpeed[brick] == 0.0f)
+    world.wallVersion++;
+  world.brickVersion++;
+  const Vector2 center = {bricks.x[brick] + bricks.width[brick] / 2,
+                          bricks.y[brick] + bricks.height[brick] / 2};
+  if (bricks.hitsRequired[brick] <= 0) {
+    SetBrickActive(bricks, brick, false);
+    bricks.moveSpeed[brick] = 0.0f; // Keep the vectorized move pass exact
+    PushGameEvent(world, GameEventType::BRICK_DESTROYED, center, brick);
+  } else {
+    PushGameEvent(world, GameEventType::BRICK_HIT, center, brick);
+  }
+
+  const float approach =
+      ball.speed.x * hit.normal.x + ball.speed.y * hit.normal.y;
+  if (approach < 0.0f) {
+    ball.speed.x -= 2.0f * approach * hit.normal.x;
+    ball.speed.y -= 2.0f * approach * hit.normal.y;
+  }
+  ball.position = {hit.contact.x + hit.normal.x * COLLISION_SKIN,
+                   hit.contact.y + hit.normal.y * COLLISION_SKIN};
+
+  if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
+    ball.speed.x = (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
+  }
+}
+
+bool IsBrickActive(const BrickStore &bricks, int brick) {
+  return (bricks.activeMask[brick >> 6] >> (brick & 63)) & 1u;
+}
+
+void SetBrickActive(BrickStore &bricks, int brick, bool active) {
+  const uint64_t bit = uint64_t{1} << (brick & 63);
+  uint64_t &word = bricks.activeMask[brick >> 6];
+  if (((word & bit) != 0) == active)
+    return;
+  word ^= bit;
+  const int change = active ? 1 : -1;
+  bricks.rowActive[brick / bricks.cols] += change;
+  bricks.activeCount += change;
+}
+
+int NextActiveBrick(const BrickStore &bricks, int brick) {
+  if (brick >= bricks.count)
+    return -1;
+  int word = brick >> 6;
+  uint64_t bits = bricks.activeMask[word] & (~uint64_t{0} << (brick & 63));
+  const int words = (bricks.count + 63) >> 6;
+  while (bits == 0) {
+    if (++word >= words)
+      return -1;
+    bits = bricks.activeMask[word];
+  }
+  return (word << 6) + __builtin_ctzll(bits); // No bits are set past count
+}
+
+// Active flags of `count` (<= 32) consecutive bricks, lowest bit first
+unsigned int ActiveBrickBits(const BrickStore &bricks, int first, int count) {
+  const int word = first >> 6;
+  const int shift = first & 63;
+  uint64_t bits = bricks.activeMask[word] >> shift;
+  if (shift + count > 64)
+    bits |= bricks.activeMask[word + 1] << (64 - shift);
+  return static_cast<unsigned int>(bits & ((uint64_t{1} << count) - 1));
+}
+
+// Circle-vs-rectangle overlap for BRICK_LANES consecutive bricks starting at
+// `first`, one result bit per brick
+unsigned int CircleRecMask(const BrickStore &bricks, Vector2 center,
+                           float radius, int first) {
+#if defined(BRICKS_USE_SSE)
+  const __m128 cx = _mm_set1_ps(center.x);
+  const __m128 cy = _mm_set1_ps(center.y);
+  const __m128 left = _mm_loadu_ps(&bricks.x[first]);
+  const __m128 top = _mm_loadu_ps(&bricks.y[first]);
+  const __m128 right = _mm_add_ps(left, _mm_loadu_ps(&bricks.width[first]));
+  const __m128 bottom = _mm_add_ps(top, _mm_loadu_ps(&bricks.height[first]));
+  const __m128 dx = _mm_sub_ps(cx, _mm_min_ps(_mm_max_ps(cx, left), right));
+  const __m128 dy = _mm_sub_ps(cy, _mm_min_ps(_mm_max_ps(cy, top), bottom));
+  const __m128 distanceSq =
+      _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+  return static_cast<unsigned int>(_mm_movemask_ps(
+      _mm_cmple_ps(distanceSq, _mm_set1_ps(radius * radius))));
+#elif defined(BRICKS_USE_NEON)
+  const float32x4_t cx = vdupq_n_f32(center.x);
+  const float32x4_t cy = vdupq_n_f32(center.y);
+  const float32x4_t left = vld1q_f32(&bricks.x[first]);
+  const float32x4_t top = vld1q_f32(&bricks.y[first]);
+  const float32x4_t right = vaddq_f32(left, vld1q_f32(&bricks.width[first]));
+  const float32x4_t bottom = vaddq_f32(top, vld1q_f32(&bricks.height[first]));
+  const float32x4_t dx = vsubq_f32(cx, vminq_f32(vmaxq_f32(cx, left), right));
+  const float32x4_t dy = vsubq_f32(cy, vminq_f32(vmaxq_f32(cy, top), bottom));
+  const float32x4_t distanceSq = vmlaq_f32(vmulq_f32(dx, dx), dy, dy);
+  const uint32x4_t inside =
+      vcleq_f32(distanceSq, vdupq_n_f32(radius * radius));
+  const uint32_t laneBits[4] = {1, 2, 4, 8};
+  return vaddvq_u32(vandq_u32(inside, vld1q_u32(laneBits)));
+#else
+  unsigned int mask = 0;
+  for (int lane = 0; lane < BRICK_LANES; lane++) {
+    const int brick = first + lane;
+    const float dx =
+        center.x - std::max(bricks.x[brick],
+                            std::min(center.x,
+                                     bricks.x[brick] + bricks.width[brick]));
+    const float dy =
+        center.y - std::max(bricks.y[brick],
+                            std::min(center.y,
+                                     bricks.y[brick] + bricks.height[brick]));
+    if (dx * dx + dy * dy <= radius * radius)
+      mask |= 1u << lane;
+  }
+  return mask;
+#endif
+}
+
+// Move the listed sliding bricks, bouncing them off the side walls. The
+// classic grid sweeps all of its bricks instead, see MoveClassicBricks().
+void MoveListedBricks(GameWorld &world) {
+  BrickStore &bricks = world.bricks;
+  for (const int i : world.movingBricks) {
+    bricks.prevX[i] = bricks.x[i];
+    bricks.x[i] += bricks.moveSpeed[i] * SIM_DT;
+    if (bricks.x[i] <= 0 || bricks.x[i] + bricks.width[i] >= SCREEN_WIDTH)
+      bricks.moveSpeed[i] *= -1;
+  }
+}
+
+// Every brick of the classic grid by its moveSpeed. Static and destroyed
+// bricks have a speed of 0 and are left in place by the same code.
+void MoveClassicBricks(BrickStore &bricks) {
+#if defined(BRICKS_USE_SSE)
+  const __m128 dt = _mm_set1_ps(SIM_DT);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 screenWidth = _mm_set1_ps(static_cast<float>(SCREEN_WIDTH));
+  const __m128 signBit = _mm_set1_ps(-0.0f);
+  for (int i = 0; i < MAX_BRICKS; i += BRICK_LANES) {
+    const __m128 x = _mm_loadu_ps(&bricks.x[i]);
+    __m128 speed = _mm_loadu_ps(&bricks.moveSpeed[i]);
+    const __m128 newX = _mm_add_ps(x, _mm_mul_ps(speed, dt));
+    const __m128 bounce = _mm_or_ps(
+        _mm_cmple_ps(newX, zero),
+        _mm_cmpge_ps(_mm_add_ps(newX, _mm_loadu_ps(&bricks.width[i])),
+                     screenWidth));
+    speed = _mm_xor_ps(speed, _mm_and_ps(bounce, signBit));
+    _mm_storeu_ps(&bricks.prevX[i], x);
+    _mm_storeu_ps(&bricks.x[i], newX);
+    _mm_storeu_ps(&bricks.moveSpeed[i], speed);
+  }
+#elif defined(BRICKS_USE_NEON)
+  const float32x4_t dt = vdupq_n_f32(SIM_DT);
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t screenWidth =
+      vdupq_n_f32(static_cast<float>(SCREEN_WIDTH));
+  for (int i = 0; i < MAX_BRICKS; i += BRICK_LANES) {
+    const float32x4_t x = vld1q_f32(&bricks.x[i]);
+    const float32x4_t speed = vld1q_f32(&bricks.moveSpeed[i]);
+    const float32x4_t newX = vmlaq_f32(x, speed, dt);
+    const uint32x4_t bounce = vorrq_u32(
+        vcleq_f32(newX, zero),
+        vcgeq_f32(vaddq_f32(newX, vld1q_f32(&bricks.width[i])), screenWidth));
+    vst1q_f32(&bricks.prevX[i], x);
+    vst1q_f32(&bricks.x[i], newX);
+    vst1q_f32(&bricks.moveSpeed[i], vbslq_f32(bounce, vnegq_f32(speed), speed));
+  }
+#else
+  for (int i = 0; i < MAX_BRICKS; i++) {
+    bricks.prevX[i] = bricks.x[i];
+    bricks.x[i] += bricks.moveSpeed[i] * SIM_DT;
+    if (bricks.x[i] <= 0 || bricks.x[i] + bricks.width[i] >= SCREEN_WIDTH)
+      bricks.moveSpeed[i] *= -1;
+  }
+#endif
+}
+
+Rectangle GetBrickRect(const BrickStore &bricks, int brick) {
+  return {bricks.x[brick], bricks.y[brick], bricks.width[brick],
+          bricks.height[brick]};
+}
+
+// Same test as raylib's CheckCollisionRecs, kept here so the core links
+// without raylib
+bool RecsOverlap(Rectangle a, Rectangle b) {
+  return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height &&
+         a.y + a.height > b.y;
+}
+
+// Cells span the screen width and are BRICK_HEIGHT tall until the wall would
+// exceed MAX_WALL_HEIGHT. The classic grid gets exactly the classic layout.
+void InitBrickGrid(BrickStore &bricks, int rows, int cols) {
+  const int count = rows * cols;
+  const int padded =
+      (count + 2 * BRICK_LANES - 1) / BRICK_LANES * BRICK_LANES;
+  bricks.rows = rows;
+  bricks.cols = cols;
+  bricks.count = count;
+  bricks.cellWidth = static_cast<float>(SCREEN_WIDTH) / cols;
+  bricks.cellHeight = std::min(BRICK_HEIGHT, MAX_WALL_HEIGHT / rows);
+  const float spacing = std::min(BRICK_SPACING, bricks.cellHeight / 4.0f);
+
+  bricks.x.assign(padded, 0.0f);
+  bricks.y.assign(padded, 0.0f);
+  bricks.width.assign(padded, 0.0f);
+  bricks.height.assign(padded, 0.0f);
+  bricks.prevX.assign(padded, 0.0f);
+  bricks.moveSpeed.assign(padded, 0.0f);
+  bricks.hitsRequired.assign(padded, 0);
+  bricks.color.assign(padded, Color{0, 0, 0, 0});
+  bricks.activeMask.assign(padded / 64 + 2, 0); // ActiveBrickBits reads ahead
+  bricks.rowActive.assign(rows, 0);
+  bricks.activeCount = 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      const int index = i * cols + j;
+      bricks.width[index] = bricks.cellWidth - spacing;
+      bricks.height[index] = bricks.cellHeight - spacing;
+      bricks.x[index] = j * bricks.cellWidth + spacing / 2.0f;
+      bricks.y[index] =
+          BRICK_OFFSET_Y + i * bricks.cellHeight + spacing / 2.0f;
+      bricks.prevX[index] = bricks.x[index];
+    }
+  }
+}
+
+bool IsClassicGrid(const BrickStore &bricks) {
+  return bricks.rows == BRICK_ROWS && bricks.cols == BRICKS_PER_ROW;
+}
+
+Color GetBrickColor(int hitsRequired) {
+  return (hitsRequired == 1)   ? Color{0, 255, 255, 255} // Neon cyan
+         : (hitsRequired == 2) ? Color{255, 0, 255, 255} // Neon purple
+                               : Color{0, 255, 0, 255};  // Neon green
+}
+
+Color GetPowerUpColor(PowerUpType type) {
+  switch (type) {
+  case PowerUpType::PADDLE_SIZE_UP:
+    return SKYBLUE;
+  case PowerUpType::BALL_SPEED_UP:
+    return RED;
+  case PowerUpType::EXTRA_LIFE:
+    return GREEN;
+  case PowerUpType::MULTI_BALL:
+    return PURPLE;
+  default:
+    return WHITE;
+  }
+}
+
+// Send the ball back up, steering it by where it struck the paddle
+void HandlePaddleCollision(GameWorld &world, Ball &ball) {
+  const Paddle &paddle = world.paddle;
+  const float shiftAmount = 0.3f;
+  const float speedMagnitude =
+      std::sqrt(ball.speed.x * ball.speed.x + ball.speed.y * ball.speed.y);
+  ball.speed.y = -std::abs(ball.speed.y);
+  const float hitPoint = (ball.position.x - paddle.rect.x) / paddle.rect.width;
+  float targetSpeedX;
+  if (hitPoint < (0.5f - shiftAmount))
+    targetSpeedX = -speedMagnitude * 0.6f;
+  else if (hitPoint > (0.5f + shiftAmount))
+    targetSpeedX = speedMagnitude * 0.6f;
+  else
+    targetSpeedX = (hitPoint - 0.5f) * 2.0f * speedMagnitude * 0.5f;
+  if (std::abs(targetSpeedX) < MIN_BALL_SPEED_X) {
+    targetSpeedX = (targetSpeedX >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X) *
+                   (1.0f + RandomRange(world.rng, -10, 10) / 100.0f);
+  }
+  ball.speed.x = targetSpeedX;
+  ball.position.y = paddle.rect.y - ball.radius - COLLISION_SKIN;
+  PushGameEvent(world, GameEventType::PADDLE_HIT, ball.position);
+}
+
+// Advance a ball by one tick, resolving every wall, paddle and brick contact
+// in time order so fast balls cannot tunnel through thin objects
+void MoveBall(GameWorld &world, Ball &ball) {
+  enum class Contact { NONE, WALL_X, WALL_TOP, PADDLE, BRICK };
+
+  float remaining = 1.0f; // Fraction of the tick still to simulate
+  for (int hits = 0; hits < MAX_BALL_HITS_PER_TICK && remaining > 0.0f;
+       hits++) {
+    const Vector2 delta = {ball.speed.x * SIM_DT * remaining,
+                           ball.speed.y * SIM_DT * remaining};
+    Contact contact = Contact::NONE;
+    float time = 1.0f;
+
+    if (delta.x > 0.0f &&
+        ball.position.x + ball.radius + delta.x >= SCREEN_WIDTH) {
+      time = std::max(0.0f, (SCREEN_WIDTH - ball.radius - ball.position.x) /
+                                delta.x);
+      contact = Contact::WALL_X;
+    } else if (delta.x < 0.0f && ball.position.x - ball.radius + delta.x <= 0) {
+      time = std::max(0.0f, (ball.radius - ball.position.x) / delta.x);
+      contact = Contact::WALL_X;
+    }
+    if (delta.y < 0.0f && ball.position.y - ball.radius + delta.y <= 0) {
+      const float t = std::max(0.0f, (ball.radius - ball.position.y) / delta.y);
+      if (t < time) {
+        time = t;
+        contact = Contact::WALL_TOP;
+      }
+    }
+
+    SweepHit paddleHit = {0};
+    world.stats.sweepTests += ball.speed.y > 0;
+    if (ball.speed.y > 0 &&
+        SweepCircleRec(ball.position, delta, ball.radius, world.paddle.rect,
+                       paddleHit) &&
+        paddleHit.time < time) {
+      time = paddleHit.time;
+      contact = Contact::PADDLE;
+    }
+
+    SweepHit brickHit = {0};
+    const int brick = FindBrickHit(world, ball, delta, brickHit);
+    if (brick >= 0 && brickHit.time < time) {
+      time = brickHit.time;
+      contact = Contact::BRICK;
+    }
+
+    ball.position.x += delta.x * time;
+    ball.position.y += delta.y * time;
+    remaining *= 1.0f - time;
+
+    switch (contact) {
+    case Contact::NONE:
+      remaining = 0.0f;
+      break;
+    case Contact::WALL_X:
+      ball.speed.x *= -1;
+      if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
+        ball.speed.x =
+            (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
+      }
+      break;
+    case Contact::WALL_TOP:
+      ball.speed.y *= -1;
+      break;
+    case Contact::PADDLE:
+      ball.position = paddleHit.contact;
+      HandlePaddleCollision(world, ball);
+      break;
+    case Contact::BRICK:
+      HandleBrickCollision(world, ball, brick, brickHit);
+      break;
+    }
+  }
+
+  if (ball.position.y + ball.radius >= SCREEN_HEIGHT) {
+    ball.active = false;
+    PushGameEvent(world, GameEventType::BALL_LOST, ball.position);
+  }
+}
+
+// Advance the playing simulation by exactly one fixed tick of SIM_DT seconds
+void UpdateSimulation(GameWorld &world, const GameInput &input) {
+  world.step(world, input);
+}
+
+// The tick, instantiated per MoverPass so only the moving-brick pass the
+// level needs is compiled into it
+template <MoverPass movers>
+void StepWorld(GameWorld &world, const GameInput &input) {
+  PROFILE_SCOPE(PROFILE_SIM_TICK);
+  world.tickCount++;
+  world.events.clear();
+
+  world.countdownTimer -= SIM_DT;
+  if (world.countdownTimer <= 0.0f) {
+    world.lives--;
+    for (auto &ball : world.balls) {
+      if (ball.active)
+        PushGameEvent(world, GameEventType::BALL_LOST, ball.position);
+      ball.active = false;
+    }
+    if (world.lives <= 0)
+      world.status = LevelStatus::LOST;
+    else
+      ResetBallsAndPaddle(world);
+  }
+
+  world.paddle.prevX = world.paddle.rect.x;
+  world.paddle.rect.x += std::max(-1.0f, std::min(input.paddleMove, 1.0f)) *
+                         PADDLE_SPEED * SIM_DT;
+  world.paddle.rect.x =
+      std::max(0.0f, std::min(world.paddle.rect.x,
+                              static_cast<float>(SCREEN_WIDTH) -
+                                  world.paddle.rect.width));
+
+  // Drop balls lost on the previous tick. Balls spawned during this tick by
+  // a power-up start moving on the next one.
+  for (int i = 0; i < world.balls.size();) {
+    if (world.balls[i].active)
+      ++i;
+    else
+      world.balls.remove(i);
+  }
+
+  const int ballCount = world.balls.size();
+  const bool anyBallActive = ballCount > 0;
+  {
+    PROFILE_SCOPE(PROFILE_SIM_BALLS);
+    for (int i = 0; i < ballCount; i++) {
+      Ball &ball = world.balls[i];
+
+      // Update trail
+      if (world.tickCount % TRAIL_SAMPLE_TICKS == 0) {
+        PushTrailPoint(ball.trail, ball.position);
+      }
+
+      ball.prevPosition = ball.position;
+      const int firstEvent = world.events.size();
+      MoveBall(world, ball);
+      ApplyGameEvents(world, firstEvent);
+    }
+  }
+
+  if (!anyBallActive) {
+    world.lives--;
+    if (world.lives <= 0)
+      world.status = LevelStatus::LOST;
+    else
+      ResetBallsAndPaddle(world);
+  }
+
+  if (movers != MoverPass::NONE) {
+    PROFILE_SCOPE(PROFILE_SIM_MOVING_BRICKS);
+    if (movers == MoverPass::CLASSIC)
+      MoveClassicBricks(world.bricks);
+    else
+      MoveListedBricks(world);
+  }
+
+  {
+    PROFILE_SCOPE(PROFILE_SIM_POWERUPS);
+    UpdatePowerUps(world);
+  }
+
+  if (world.bricks.activeCount == 0)
+    world.status = LevelStatus::CLEARED;
+}
+
+void TakeSnapshot(const GameWorld &world, GameSnapshot &snapshot) {
+  snapshot.paddle = world.paddle;
+  snapshot.balls = world.balls;
+  snapshot.powerUps = world.powerUps;
+  if (snapshot.brickVersion != world.brickVersion ||
+      snapshot.bricks.count != world.bricks.count) {
+    snapshot.bricks = world.bricks;
+    snapshot.brickVersion = world.brickVersion;
+  } else {
+    for (const int brick : world.movingBricks) {
+      snapshot.bricks.x[brick] = world.bricks.x[brick];
+      snapshot.bricks.prevX[brick] = world.bricks.prevX[brick];
+      snapshot.bricks.moveSpeed[brick] = world.bricks.moveSpeed[brick];
+    }
+  }
+  snapshot.difficulty = world.difficulty;
+  snapshot.status = world.status;
+  snapshot.score = world.score;
+  snapshot.lives = world.lives;
+  snapshot.countdownTimer = world.countdownTimer;
+  snapshot.tickCount = world.tickCount;
+  snapshot.wallVersion = world.wallVersion;
+  snapshot.hasNextLevel = HasNextLevel(world);
+  snapshot.stats = world.stats;
+}
+
+void PushTrailPoint(BallTrail &trail, Vector2 point) {
+  trail.newest = (trail.newest + 1) % TRAIL_LENGTH;
+  trail.points[trail.newest] = point;
+  trail.count = std::min(trail.count + 1, TRAIL_LENGTH);
+}
+
+Vector2 GetTrailPoint(const BallTrail &trail, int age) {
+  return trail.points[(trail.newest - age + TRAIL_LENGTH) % TRAIL_LENGTH];
+}
+
+void SeedRng(GameRng &rng, uint64_t seed) {
+  rng.state = 0;
+  rng.increment = (seed << 1) | 1;
+  NextRandom(rng);
+  rng.state += seed;
+  NextRandom(rng);
+}
+
+uint32_t NextRandom(GameRng &rng) {
+  const uint64_t old = rng.state;
+  rng.state = old * 6364136223846793005ULL + rng.increment;
+  const uint32_t xorShifted =
+      static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+  const uint32_t rotation = static_cast<uint32_t>(old >> 59u);
+  return (xorShifted >> rotation) | (xorShifted << ((-rotation) & 31));
+}
+
+// Uniform integer in [min, max] by multiply-shift, no division on the hot path
+int RandomRange(GameRng &rng, int min, int max) {
+  const uint64_t range = static_cast<uint64_t>(max - min) + 1;
+  return min + static_cast<int>((NextRandom(rng) * range) >> 32);
+}
@@ -0,0 +1,360 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "levels.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Simulation core: everything needed to play a level without a window, GPU
+// or keyboard. Rendering and input live in main.cpp.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+// Logical screen the simulation works in. The renderer scales it to the
+// window, so these are not window pixels.
+constexpr int SCREEN_WIDTH = 1280;
+constexpr int SCREEN_HEIGHT = 768;
+
+// Simulation runs on a fixed tick, independent of the render frame rate.
+// All speeds below are expressed in pixels per second.
+constexpr float SIM_TICK_RATE = 120.0f;
+constexpr float SIM_DT = 1.0f / SIM_TICK_RATE;
+
+constexpr float PADDLE_WIDTH = 100.0f;
+constexpr float PADDLE_HEIGHT = 20.0f;
+constexpr float PADDLE_SPEED = 480.0f;
+
+constexpr float BALL_RADIUS = 10.0f;
+constexpr float INITIAL_BALL_SPEED_X = 240.0f;
+constexpr float INITIAL_BALL_SPEED_Y = -240.0f;
+constexpr float MIN_BALL_SPEED_X = 120.0f;
+constexpr int TRAIL_SAMPLE_TICKS = 2; // Record a trail point every N ticks
+constexpr int TRAIL_LENGTH = 5;       // Points kept per ball, subtle trail
+constexpr int MAX_BALL_HITS_PER_TICK = 8;  // Bounces resolved within one tick
+constexpr float COLLISION_SKIN = 0.1f;     // Separation kept after a bounce
+
+// The classic wall. Other grid sizes are set at runtime and have their own
+// cell size, see InitBrickGrid().
+constexpr int BRICK_ROWS = 6;
+constexpr int BRICKS_PER_ROW = 10;
+constexpr float BRICK_WIDTH = static_cast<float>(SCREEN_WIDTH) / BRICKS_PER_ROW;
+constexpr float BRICK_HEIGHT = 30.0f; // Also the tallest row of any grid
+constexpr float BRICK_SPACING = 2.0f;
+constexpr float BRICK_OFFSET_Y = 50.0f;   // Top of the brick grid
+constexpr float MAX_WALL_HEIGHT = 400.0f; // Taller grids get shorter rows
+constexpr int MAX_GRID_ROWS = 200;
+constexpr int MAX_GRID_COLS = 320;
+constexpr float MOVING_BRICK_SPEED = 120.0f;
+constexpr int MAX_BRICKS = BRICK_ROWS * BRICKS_PER_ROW; // In the classic wall
+constexpr int BRICK_LANES = 4; // Bricks tested per SIMD instruction
+
+constexpr float TIME_LIMIT_EASY = 180.0f;    // 3 minutes
+constexpr float TIME_LIMIT_MEDIUM = 180.0f; // 3 minutes
+constexpr float TIME_LIMIT_HARD = 180.0f;   // 3 minutes
+
+constexpr float POWERUP_SIZE = 20.0f;
+constexpr float POWERUP_SPEED = 120.0f;
+
+// Pool capacities. Spawns beyond these are dropped, so the simulation never
+// allocates while a level is running. Override with -DBALL_POOL_SIZE=n etc.
+#ifndef BALL_POOL_SIZE
+#define BALL_POOL_SIZE 32
+#endif
+#ifndef POWERUP_POOL_SIZE
+#define POWERUP_POOL_SIZE 32
+#endif
+
+// Every event one tick can raise: each ball resolving all its hits, each
+// destroyed brick spawning a power-up, each ball lost and each power-up
+// collected. Capped at GAME_EVENT_LIMIT, so pools built far larger do not
+// grow every world; events past the cap still apply their rules but are not
+// kept for presentation, and are counted in SimStats::droppedEvents.
+constexpr int GAME_EVENT_LIMIT = 1024;
+constexpr int GAME_EVENT_CAPACITY =
+    std::min(BALL_POOL_SIZE * (2 * MAX_BALL_HITS_PER_TICK + 1) +
+                 POWERUP_POOL_SIZE,
+             GAME_EVENT_LIMIT);
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Fixed-capacity array. Removal swaps the last item into the hole, so item
+// order is not preserved.
+template <typename T, int Capacity> struct Pool {
+  T items[Capacity];
+  int count = 0;
+
+  T *begin() { return items; }
+  T *end() { return items + count; }
+  const T *begin() const { return items; }
+  const T *end() const { return items + count; }
+  T &operator[](int i) { return items[i]; }
+  const T &operator[](int i) const { return items[i]; }
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == Capacity; }
+  void clear() { count = 0; }
+
+  // Returns false, leaving the pool unchanged, when it is full
+  bool push_back(const T &item) {
+    if (count == Capacity)
+      return false;
+    items[count++] = item;
+    return true;
+  }
+
+  void remove(int i) {
+    if (i != count - 1)
+      items[i] = items[count - 1];
+    count--;
+  }
+};
+
+struct Paddle {
+  Rectangle rect;
+  float prevX; // Position at the previous tick, for interpolation
+  Color color;
+};
+
+// Last TRAIL_LENGTH sampled positions of a ball, stored inline
+struct BallTrail {
+  Vector2 points[TRAIL_LENGTH];
+  int newest; // Slot of the most recent point
+  int count;
+};
+
+struct Ball {
+  Vector2 position;
+  Vector2 prevPosition; // Position at the previous tick, for interpolation
+  Vector2 speed;
+  float radius;
+  bool active;
+  Color color;
+  BallTrail trail;
+};
+static_assert(std::is_trivially_copyable<Ball>::value,
+              "Balls are copied by value, e.g. by multi-ball");
+
+// Bricks are stored as a structure of arrays indexed by row * cols + col, so
+// each pass streams only the columns it needs. The arrays are padded so a
+// BRICK_LANES-wide load starting at any brick stays in bounds, and keep
+// their capacity when a level of the same size is set up.
+struct BrickStore {
+  int rows;
+  int cols;
+  int count;        // rows * cols
+  float cellWidth;  // Grid pitch. A static brick lies inside its own cell.
+  float cellHeight;
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> width;
+  std::vector<float> height;
+  std::vector<float> prevX; // x at the previous tick
+  std::vector<float> moveSpeed;
+  std::vector<int> hitsRequired;
+  std::vector<Color> color;
+  std::vector<uint64_t> activeMask; // One bit per brick
+  std::vector<int> rowActive;       // Active bricks in each row
+  int activeCount;                  // Active bricks in the store
+};
+
+enum class PowerUpType {
+  NONE,
+  PADDLE_SIZE_UP,
+  BALL_SPEED_UP,
+  EXTRA_LIFE,
+  MULTI_BALL
+};
+
+struct PowerUp {
+  Rectangle rect;
+  float prevY; // Position at the previous tick, for interpolation
+  PowerUpType type;
+  bool active;
+  Color color;
+};
+
+// Something the simulation resolved during a tick. Collisions and pickups only
+// record these; scoring, power-up spawns and pickups are applied from them
+// after each ball and after the power-up pass, and presentation (particles,
+// audio) reads them once the tick is done.
+enum class GameEventType : uint8_t {
+  BRICK_HIT,       // Brick took a hit and still stands
+  BRICK_DESTROYED,
+  PADDLE_HIT,
+  POWERUP_SPAWNED,
+  POWERUP_COLLECTED,
+  BALL_LOST
+};
+
+struct GameEvent {
+  GameEventType type;
+  uint8_t powerUp;  // PowerUpType of POWERUP_* events
+  uint16_t brick;   // Brick of BRICK_* events
+  Vector2 position; // Brick center, ball or power-up position
+};
+static_assert(sizeof(GameEvent) == 12 && MAX_GRID_ROWS * MAX_GRID_COLS <= 65536,
+              "Events stay small and can name any brick");
+
+enum class Difficulty { EASY, MEDIUM, HARD };
+constexpr int DIFFICULTY_COUNT = 3;
+
+// Everything a difficulty changes, read once when a level is set up. New
+// rules are a new row of DIFFICULTY_CONFIGS, the tick never asks which
+// difficulty it is playing.
+struct DifficultyConfig {
+  const char *name;
+  float powerUpSpawnChance; // Per destroyed brick
+  float paddleWidth;        // At the start of each level
+  float ballSpeedScale;     // Of INITIAL_BALL_SPEED_X and _Y at each serve
+  int emptyRowsDivisor;     // Generated walls leave rows / N empty, 0 none
+  int maxHits;              // Generated bricks take 1 .. maxHits hits
+  int movingBrickChance;    // Percent of the lowest row that slides
+  float timeLimit;          // Seconds, unless a pack level sets its own
+};
+
+constexpr DifficultyConfig DIFFICULTY_CONFIGS[DIFFICULTY_COUNT] = {
+    {"EASY", 0.2f, PADDLE_WIDTH * 1.5f, 0.8f, 2, 1, 0, TIME_LIMIT_EASY},
+    {"MEDIUM", 0.3f, PADDLE_WIDTH * 0.7f, 1.2f, 6, 2, 0, TIME_LIMIT_MEDIUM},
+    {"HARD", 0.4f, PADDLE_WIDTH * 0.5f, 1.5f, 0, 3, 30, TIME_LIMIT_HARD}};
+static_assert(LEVEL_MAX_DIFFICULTY == DIFFICULTY_COUNT - 1,
+              "Level packs name every difficulty");
+
+constexpr const DifficultyConfig &GetDifficultyConfig(Difficulty diff) {
+  return DIFFICULTY_CONFIGS[static_cast<int>(diff)];
+}
+
+// PCG32 generator. Every random decision in a game draws from its world's
+// stream, so the same seed and inputs replay the same game bit for bit.
+struct GameRng {
+  uint64_t state;
+  uint64_t increment; // Stream selector, always odd
+};
+
+// Outcome of the level being simulated
+enum class LevelStatus { PLAYING, LOST, CLEARED };
+
+// Player intent for one tick
+struct GameInput {
+  float paddleMove; // -1 (full left) .. 1 (full right)
+};
+
+// Work counters, accumulated until reset by the caller
+struct SimStats {
+  uint64_t broadphaseTests; // Grid cells visited by the brick broadphase
+  uint64_t sweepTests;      // Exact swept circle-vs-rectangle tests
+  uint64_t droppedEvents;   // Raised past GAME_EVENT_CAPACITY
+};
+
+// Balancing multipliers on top of the per-difficulty values, for sweeps.
+// The defaults leave every game exactly as designed.
+struct GameTuning {
+  float powerUpChanceScale; // Scales powerUpSpawnChance
+  float paddleWidthScale;   // Scales the starting paddle width
+  float ballSpeedScale;     // Scales the serve speed
+};
+
+constexpr GameTuning DEFAULT_TUNING = {1.0f, 1.0f, 1.0f};
+
+struct GameWorld;
+
+// One tick of the rules, compiled for the kind of level being played
+using SimulationStep = void (*)(GameWorld &world, const GameInput &input);
+
+// Complete state of one game in progress
+struct GameWorld {
+  Paddle paddle;
+  Pool<Ball, BALL_POOL_SIZE> balls;
+  BrickStore bricks;
+  std::vector<int> movingBricks; // Indices of bricks with moveSpeed != 0
+  Pool<PowerUp, POWERUP_POOL_SIZE> powerUps;
+  Difficulty difficulty;
+  LevelStatus status;
+  int score;
+  int lives;
+  float countdownTimer;
+  float powerUpSpawnChance;
+  unsigned int tickCount;
+  unsigned int wallVersion; // Bumped whenever a static brick changes
+  unsigned int brickVersion; // Bumped on any brick change but a move
+  SimStats stats;
+  uint64_t seed; // Seed the current game was started with
+  GameRng rng;
+  GameTuning tuning;
+  const LevelPack *levelPack; // Designed levels, nullptr to generate them
+  int packLevel;              // Entry of levelPack being played
+  int level;                  // 1 for the first level of the game
+  int wallRows; // Size of generated walls, 0 for the classic grid
+  int wallCols;
+  Pool<GameEvent, GAME_EVENT_CAPACITY> events; // Raised by the last tick
+  SimulationStep step; // Chosen by SetupLevel()
+};
+
+// Read-only copy of everything a frame needs to draw one tick, so a
+// renderer never touches a world that is being simulated
+struct GameSnapshot {
+  Paddle paddle;
+  Pool<Ball, BALL_POOL_SIZE> balls;
+  Pool<PowerUp, POWERUP_POOL_SIZE> powerUps;
+  BrickStore bricks;
+  Difficulty difficulty;
+  LevelStatus status;
+  int score;
+  int lives;
+  float countdownTimer;
+  unsigned int tickCount;
+  unsigned int wallVersion;
+  unsigned int brickVersion; // Of the world the bricks were copied from
+  bool hasNextLevel;         // What AdvanceLevel() would do once cleared
+  SimStats stats;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// With world.levelPack set the game plays the pack from its first level of
+// difficulty diff, otherwise every level is generated from the seed
+void StartGame(GameWorld &world, Difficulty diff, uint64_t seed,
+               const GameTuning &tuning = DEFAULT_TUNING);
+void SetupLevel(GameWorld &world, Difficulty diff);
+void ResetBallsAndPaddle(GameWorld &world);
+// Stress load: serve-speed balls at random points below the wall until the
+// world has balls of them, and falling multi-ball power-ups until it has
+// powerUps. Returns the spawns the full pools refused.
+int SpawnStressLoad(GameWorld &world, int balls, int powerUps);
+// The next pack entry, or a harder generated wall, follows this level
+bool HasNextLevel(const GameWorld &world);
+bool AdvanceLevel(GameWorld &world);
+void UpdateSimulation(GameWorld &world, const GameInput &input);
+// snapshot keeps the bricks of an earlier snapshot of the same world and only
+// copies what changed: the moving bricks every tick, the whole wall only after
+// a hit or a level setup
+void TakeSnapshot(const GameWorld &world, GameSnapshot &snapshot);
+bool IsBrickActive(const BrickStore &bricks, int brick);
+// Also keeps rowActive and activeCount, so the brick counts are never
+// maintained by hand
+void SetBrickActive(BrickStore &bricks, int brick, bool active);
+// First active brick at or after brick, -1 if there is none. Skips 64 empty
+// cells per step, so a loop over it costs what is left of the wall.
+int NextActiveBrick(const BrickStore &bricks, int brick);
+Rectangle GetBrickRect(const BrickStore &bricks, int brick);
+// Lay out every cell of a rows x cols grid, all inactive
+void InitBrickGrid(BrickStore &bricks, int rows, int cols);
+bool IsClassicGrid(const BrickStore &bricks);
+Color GetBrickColor(int hitsRequired);
+Color GetPowerUpColor(PowerUpType type);
+void PushTrailPoint(BallTrail &trail, Vector2 point);
+Vector2 GetTrailPoint(const BallTrail &trail, int age); // 0 is the newest
+void SeedRng(GameRng &rng, uint64_t seed);
+uint32_t NextRandom(GameRng &rng);
+int RandomRange(GameRng &rng, int min, int max); // Inclusive of both ends
+
+#endif // GAME_H
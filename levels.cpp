@@ -0,0 +1,183 @@
+#include "levels.h"
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+static const char LEVEL_PACK_MAGIC[4] = {'B', 'R', 'K', 'P'};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static bool MapFile(LevelPack &pack, const char *fileName);
+static void UnmapFile(LevelPack &pack);
+static bool ReadIndex(LevelPack &pack, int maxRows, int maxCols);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+bool OpenLevelPack(LevelPack &pack, const char *fileName, int maxRows,
+                   int maxCols) {
+  pack = {0};
+  pack.mapping = -1;
+  if (!MapFile(pack, fileName))
+    return false;
+  if (!ReadIndex(pack, maxRows, maxCols)) {
+    CloseLevelPack(pack);
+    return false;
+  }
+  return true;
+}
+
+void CloseLevelPack(LevelPack &pack) {
+  if (pack.data != nullptr)
+    UnmapFile(pack);
+  pack = {0};
+  pack.mapping = -1;
+}
+
+const uint8_t *GetLevelCells(const LevelPack &pack, int level) {
+  return pack.data + pack.entries[level].cellsOffset;
+}
+
+uint32_t HashLevelPack(const LevelPack &pack) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < pack.size; i++)
+    hash = (hash ^ pack.data[i]) * 16777619u;
+  return hash;
+}
+
+bool SaveLevelPack(const std::vector<LevelDesign> &levels,
+                   const char *fileName) {
+  if (levels.size() > UINT16_MAX)
+    return false;
+  LevelPackHeader header = {0};
+  std::copy(LEVEL_PACK_MAGIC, LEVEL_PACK_MAGIC + 4, header.magic);
+  header.version = LEVEL_PACK_VERSION;
+  header.levelCount = static_cast<uint16_t>(levels.size());
+  header.indexOffset = sizeof(LevelPackHeader);
+
+  std::vector<LevelPackEntry> index;
+  uint32_t offset =
+      header.indexOffset +
+      static_cast<uint32_t>(levels.size() * sizeof(LevelPackEntry));
+  for (const auto &level : levels) {
+    if (level.rows <= 0 || level.cols <= 0 ||
+        level.cells.size() != static_cast<size_t>(level.rows * level.cols))
+      return false;
+    LevelPackEntry entry = {0};
+    entry.cellsOffset = offset;
+    entry.rows = static_cast<uint16_t>(level.rows);
+    entry.cols = static_cast<uint16_t>(level.cols);
+    entry.difficulty = static_cast<uint8_t>(level.difficulty);
+    entry.timeLimit = static_cast<uint16_t>(level.timeLimit);
+    index.push_back(entry);
+    offset += static_cast<uint32_t>(level.cells.size());
+  }
+
+  FILE *file = std::fopen(fileName, "wb");
+  if (file == nullptr)
+    return false;
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(index.data(), sizeof(LevelPackEntry),
+                             index.size(), file) == index.size();
+  for (const auto &level : levels) {
+    written = written && std::fwrite(level.cells.data(), 1, level.cells.size(),
+                                     file) == level.cells.size();
+  }
+  return std::fclose(file) == 0 && written;
+}
+
+// Every offset is checked once here so setting up a level can trust the index
+bool ReadIndex(LevelPack &pack, int maxRows, int maxCols) {
+  if (pack.size < sizeof(LevelPackHeader))
+    return false;
+  const LevelPackHeader &header =
+      *reinterpret_cast<const LevelPackHeader *>(pack.data);
+  if (!std::equal(header.magic, header.magic + 4, LEVEL_PACK_MAGIC) ||
+      header.version != LEVEL_PACK_VERSION || header.levelCount == 0 ||
+      header.indexOffset % alignof(LevelPackEntry) != 0 ||
+      header.indexOffset > pack.size ||
+      (pack.size - header.indexOffset) / sizeof(LevelPackEntry) <
+          header.levelCount)
+    return false;
+
+  const LevelPackEntry *entries =
+      reinterpret_cast<const LevelPackEntry *>(pack.data + header.indexOffset);
+  for (int level = 0; level < header.levelCount; level++) {
+    const LevelPackEntry &entry = entries[level];
+    const size_t cells = static_cast<size_t>(entry.rows) * entry.cols;
+    if (entry.rows == 0 || entry.cols == 0 || entry.rows > maxRows ||
+        entry.cols > maxCols || entry.difficulty > LEVEL_MAX_DIFFICULTY ||
+        entry.cellsOffset > pack.size || pack.size - entry.cellsOffset < cells)
+      return false;
+  }
+
+  pack.entries = entries;
+  pack.levelCount = header.levelCount;
+  return true;
+}
+
+#if defined(_WIN32)
+bool MapFile(LevelPack &pack, const char *fileName) {
+  const HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING, 0, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size = {0};
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file); // The mapping keeps the file open
+  if (mapping == nullptr)
+    return false;
+  const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(mapping);
+    return false;
+  }
+  pack.data = static_cast<const uint8_t *>(data);
+  pack.size = static_cast<size_t>(size.QuadPart);
+  pack.mapping = reinterpret_cast<intptr_t>(mapping);
+  return true;
+}
+
+void UnmapFile(LevelPack &pack) {
+  UnmapViewOfFile(pack.data);
+  CloseHandle(reinterpret_cast<HANDLE>(pack.mapping));
+}
+#else
+bool MapFile(LevelPack &pack, const char *fileName) {
+  const int file = open(fileName, O_RDONLY);
+  if (file < 0)
+    return false;
+  struct stat info = {0};
+  void *data = MAP_FAILED;
+  if (fstat(file, &info) == 0 && info.st_size > 0) {
+    data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                MAP_PRIVATE, file, 0);
+  }
+  close(file); // The mapping keeps the file open
+  if (data == MAP_FAILED)
+    return false;
+  pack.data = static_cast<const uint8_t *>(data);
+  pack.size = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void UnmapFile(LevelPack &pack) {
+  munmap(const_cast<uint8_t *>(pack.data), pack.size);
+}
+#endif
@@ -0,0 +1,85 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Level packs: designed levels in one binary file that is memory mapped and
+// read in place, so setting up a level only copies its cells into the wall.
+//
+// File layout (little endian):
+//   LevelPackHeader
+//   LevelPackEntry[levelCount], the index
+//   cells of each level at its entry's offset, rows * cols bytes row by row:
+//     0 for an empty cell, else hits required (1..LEVEL_CELL_HITS) with
+//     LEVEL_CELL_MOVING set for bricks that slide sideways
+// Kept apart from raylib so the system mapping headers never meet its names.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr uint16_t LEVEL_PACK_VERSION = 1;
+constexpr uint8_t LEVEL_CELL_HITS = 0x0F; // Mask of the hit count
+constexpr uint8_t LEVEL_CELL_MOVING = 0x80;
+constexpr uint8_t LEVEL_MAX_DIFFICULTY = 2; // Difficulty::HARD
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct LevelPackHeader {
+  char magic[4]; // 'B', 'R', 'K', 'P'
+  uint16_t version;
+  uint16_t levelCount;
+  uint32_t indexOffset; // File offset of the first LevelPackEntry
+  uint32_t reserved;
+};
+
+struct LevelPackEntry {
+  uint32_t cellsOffset; // File offset of the level's first cell
+  uint16_t rows;
+  uint16_t cols;
+  uint8_t difficulty; // Difficulty whose rules the level plays by
+  uint8_t reserved;
+  uint16_t timeLimit; // Seconds, 0 for the difficulty's default
+};
+
+static_assert(sizeof(LevelPackHeader) == 16 && sizeof(LevelPackEntry) == 12,
+              "Pack structures are read in place from the file");
+
+// An open pack. entries and the cells they point to live in the mapping.
+struct LevelPack {
+  const uint8_t *data;
+  size_t size;
+  const LevelPackEntry *entries;
+  int levelCount;
+  intptr_t mapping; // Platform mapping handle
+};
+
+// One level to write into a pack
+struct LevelDesign {
+  int rows;
+  int cols;
+  int difficulty;
+  int timeLimit;
+  std::vector<uint8_t> cells; // rows * cols, encoded as in the file
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Map fileName and check its index. Returns false for a missing or malformed
+// pack, or one with a level larger than maxRows x maxCols.
+bool OpenLevelPack(LevelPack &pack, const char *fileName, int maxRows,
+                   int maxCols);
+void CloseLevelPack(LevelPack &pack);
+const uint8_t *GetLevelCells(const LevelPack &pack, int level);
+uint32_t HashLevelPack(const LevelPack &pack); // FNV-1a of the whole file
+
+bool SaveLevelPack(const std::vector<LevelDesign> &levels,
+                   const char *fileName);
+
+#endif // LEVELS_H
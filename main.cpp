@@ -1,39 +1,74 @@
+#include "assets.h"
+#include "audio.h"
+#include "autopilot.h"
+#include "event_ring.h"
+#include "game.h"
+#include "levels.h"
+#include "net.h"
+#include "particles.h"
+#include "profiler.h"
 #include "raylib.h"
+#include "raymath.h"
+#include "records.h"
+#include "replay.h"
+#include "rlgl.h"
+#include "session.h"
+#include "text_cache.h"
+#include "triple_buffer.h"
+#include "udp.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
-#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <new>
 #include <random>
-#include <vector>
+#include <string>
+#include <thread>
 
 //----------------------------------------------------------------------------------
 // Defines and Global Constants
 //----------------------------------------------------------------------------------
-constexpr int SCREEN_WIDTH = 1280;
-constexpr int SCREEN_HEIGHT = 768;
-
-constexpr float PADDLE_WIDTH = 100.0f;
-constexpr float PADDLE_HEIGHT = 20.0f;
-constexpr float PADDLE_SPEED = 8.0f;
-
-constexpr float BALL_RADIUS = 10.0f;
-constexpr float INITIAL_BALL_SPEED_X = 4.0f;
-constexpr float INITIAL_BALL_SPEED_Y = -4.0f;
-constexpr float MIN_BALL_SPEED_X = 2.0f;
-
-constexpr int BRICK_ROWS = 6;
-constexpr int BRICKS_PER_ROW = 10;
-constexpr float BRICK_WIDTH = static_cast<float>(SCREEN_WIDTH) / BRICKS_PER_ROW;
-constexpr float BRICK_HEIGHT = 30.0f;
-constexpr float BRICK_SPACING = 2.0f;
-
-constexpr float TIME_LIMIT_EASY = 180.0f;    // 3 minutes
-constexpr float TIME_LIMIT_MEDIUM = 180.0f; // 3 minutes
-constexpr float TIME_LIMIT_HARD = 180.0f;   // 3 minutes
-
-constexpr float POWERUP_SIZE = 20.0f;
-constexpr float POWERUP_SPEED = 2.0f;
-static float powerUpSpawnChance = 0.1f;
+constexpr float MAX_FRAME_TIME = 0.25f; // Clamp long stalls (avoid spiral)
+constexpr int TARGET_FPS = 0;           // 0 = uncapped, paced by VSYNC
+
+constexpr float PADDLE_ROUNDNESS = 0.8f;
+constexpr int PADDLE_SEGMENTS = 16;
+constexpr float BRICK_ROUNDNESS = 0.2f;
+constexpr int BRICK_SEGMENTS = 8;
+constexpr float ROUNDED_BRICK_HEIGHT = 15.0f; // Shorter bricks are plain quads
+constexpr float LABELED_BRICK_HEIGHT = 24.0f; // Room for a hit-count label
+constexpr int TRAIL_SEGMENTS = 12; // Triangles per trail circle
+constexpr int DEBRIS_PER_BRICK = 24;  // Particles when a brick breaks
+constexpr int SPARKS_PER_BOUNCE = 10; // Particles when a ball leaves the paddle
+constexpr int EVENT_RING_CAPACITY = 4096; // Game events between two frames
+constexpr int INPUT_RING_CAPACITY = 256;  // Input samples between two ticks
+constexpr float GAMEPAD_DEADZONE = 0.15f; // Stick travel read as centered
+constexpr float ATTRACT_IDLE_TIME = 30.0f; // Idle menu seconds before a demo
+constexpr int AUTOPILOT_RESULT_TICKS = 360; // Result screen shown, 3 seconds
+constexpr float STRESS_STAGE_TIME = 5.0f;  // Seconds each ball count runs
+constexpr int STRESS_FRAME_SAMPLES = 1 << 16; // Reserved, so none allocate
+constexpr float MIN_RENDER_SCALE = 0.5f;  // Of the window's native resolution
+constexpr float RENDER_SCALE_STEP = 0.1f;
+constexpr float FRAME_BUDGET = 1.0f / 60.0f; // Frame time dynamic scaling holds
+constexpr float FRAME_BUDGET_SLACK = 1.15f;  // Slower than this is a late frame
+constexpr float FRAME_TIME_SMOOTHING = 0.1f; // Weight of the newest frame
+constexpr float SCALE_SETTLE_TIME = 0.5f;    // Seconds ignored after a change
+constexpr float SCALE_PROBE_DELAY = 2.0f;    // On budget this long: step up
+constexpr float MAX_SCALE_PROBE_DELAY = 64.0f;
+const char *PROFILE_CSV_FILE = "profile.csv"; // F2 capture outputs
+const char *PROFILE_TRACE_FILE = "profile.json";
+const char *RECORDS_FILE = "scores.dat"; // Game records and high scores
+
+// Triangle-list vertices of one rounded rectangle: three bands plus four
+// corner fans of `segments` triangles each, or one quad for 0 segments
+constexpr int RoundedRectVertexCount(int segments) {
+  return (segments == 0) ? 6 : 18 + 12 * segments;
+}
 
 // Custom matte black color (#0F0F0F)
 const Color MATTE_BLACK = {15, 15, 15, 255}; // RGB(15, 15, 15), fully opaque
@@ -41,99 +76,360 @@ const Color MATTE_BLACK = {15, 15, 15, 255}; // RGB(15, 15, 15), fully opaque
 //----------------------------------------------------------------------------------
 // Types and Structures Definition
 //----------------------------------------------------------------------------------
-struct Paddle {
-  Rectangle rect;
-  Color color;
-};
 
-struct Ball {
-  Vector2 position;
-  Vector2 speed;
-  float radius;
-  bool active;
-  bool hasCollided; // Track if ball has collided this frame
-  Color color;
-  std::deque<Vector2> trail;                  // Store trail positions
-  static constexpr size_t maxTrailLength = 5; // Reduced for subtle trail
+// One published simulation tick
+struct FrameSnapshot {
+  GameSnapshot game;
+  GameState state;
+  bool paused;
+  int level;
+  double tickTime; // Clock time the last tick ended, for interpolation
+  double inputTime; // Newest input change simulated, 0 for none
 };
 
-struct Brick {
-  Rectangle rect;
-  bool active;
-  int hitsRequired;
-  float moveSpeed;
-  Color color;
+// Input as polled on the main thread. The simulation applies each sample
+// from the tick running when it was taken, or the next one it simulates.
+struct InputSample {
+  double time;     // Clock time raylib polled the devices
+  uint8_t held;    // REPLAY_LEFT/RIGHT at REPLAY_ANALOG speed
+  uint8_t pressed; // Other REPLAY_* bits
 };
 
-enum class PowerUpType {
-  NONE,
-  PADDLE_SIZE_UP,
-  BALL_SPEED_UP,
-  EXTRA_LIFE,
-  MULTI_BALL
+// One ball count of a --stress run, measured from the main thread
+struct StressStage {
+  int balls;
+  double startTime;
+  SimStats startStats;     // Counters of the snapshot shown first
+  unsigned int startTick;
+  unsigned int startRefused;
+  unsigned int startDropped; // Particles cut at the cap
+  std::vector<float> frameTimes; // Seconds
 };
 
-struct PowerUp {
-  Rectangle rect;
-  PowerUpType type;
-  bool active;
-  Color color;
+// HUD lines keyed by the values they show, laid out again only when those
+// change
+struct HudText {
+  TextRun score;
+  TextRun lives;
+  TextRun time;  // Keyed by whole seconds left
+  TextRun level; // Keyed by level and difficulty
 };
 
-enum class GameState { MENU, PLAYING, GAME_OVER, YOU_WIN };
+// Fixed strings, laid out once by LoadTextCache()
+struct StaticText {
+  TextRun title;
+  TextRun menuOptions[DIFFICULTY_COUNT];
+  TextRun menuHint;
+  TextRun backHint;
+  TextRun paused;
+  TextRun gameOver;
+  TextRun youWin;
+  TextRun nextLevel;
+  TextRun toMenu;
+  TextRun waiting;
+  TextRun demo;
+  TextRun highScores;
+};
 
-enum class Difficulty { EASY, MEDIUM, HARD };
+// Dynamic resolution: steps the render scale down while frames run late and
+// probes back up after a stretch on budget, waiting longer after every probe
+// that did not hold
+struct RenderScaler {
+  float scale;            // Internal / native resolution, 1 at full quality
+  float fixedScale;       // --render-scale, 0 for dynamic
+  float frameTime;        // Smoothed seconds per frame
+  float settleTime;       // Left before frame times count again
+  float onBudgetTime;     // Seconds on budget since the last change
+  float probeDelay;       // On-budget seconds needed to step up
+  bool probing;           // Last change was a step up
+};
 
 //------------------------------------------------------------------------------------
 // Global Variables
 //------------------------------------------------------------------------------------
-static Paddle paddle = {0};
-static std::vector<Ball> balls;
-static Brick bricks[BRICK_ROWS][BRICKS_PER_ROW] = {0};
-static std::vector<PowerUp> powerUps;
-static Texture2D backgroundTexture = {0}; // Background image
-static int score = 0;
-static int lives = 3;
-static GameState currentState = GameState::MENU;
+// While the simulation thread runs it owns session and the replay state below.
+// The main thread only touches them after StopSimulation().
+static GameSession session;                   // Game being played
+static TripleBuffer<FrameSnapshot> snapshots; // Simulation -> renderer
+// Every tick's events, also the ones no snapshot shows. Spectating fills it
+// from the main thread, the simulation thread does not run then.
+static EventRing<GameEvent, EVENT_RING_CAPACITY> gameEvents;
+static std::thread simThread;
+static std::atomic<bool> simRunning(false);  // Cleared to stop the thread
+static EventRing<InputSample, INPUT_RING_CAPACITY> inputSamples; // -> sim
+static uint8_t simHeld = 0;         // Held input of the last tick, sim only
+static double simInputTime = 0.0;   // Newest sample it applied, sim only
+static uint8_t sentHeld = 0;        // Held input of the last sample queued
+static double inputPollTime = 0.0;  // When raylib last polled the devices
+static double latchedInputTime = 0.0; // inputTime of the paddle on screen
+static double shownInputTime = 0.0;   // Newest inputTime measured on screen
+static bool mouseInput = false;     // --mouse: a mouse or spinner steers
+static float mouseCarry = 0.0f;     // Mouse travel not sent yet, logical units
+static PaddleController autopilot = nullptr;  // Plays this game, if set
+static PaddleController soakPlayer = nullptr; // --autopilot: plays every game
+static bool attractMode = false;    // Demo started from the idle menu
+static float menuIdleTime = 0.0f;   // Seconds since a key was pressed in it
+static int autopilotGames = 0;      // Games started by soak or attract mode
+static int resultTicks = 0;         // Autopilot on a result screen, sim only
+static int stressBalls = 0;         // --stress: balls of the last stage
+static int stressPowerUps = 0;      // Power-ups held in play throughout
+static std::atomic<int> stressBallTarget(0);      // Main thread -> sim
+static std::atomic<unsigned int> stressRefused(0); // Sim -> main thread
+static StressStage stress;          // Running while stress.balls > 0
+static bool stressFinished = false; // Ends the main loop
+static bool recordingGame = false;  // Logged to the record store when over
+static FrameTimeStats gameFrameTimes = {0}; // Frames drawn while playing
+static int gamePowerUps = 0;                // Collected this game
+static HighScoreTable highScores = {0};     // Copy shown in the menu
+static TextRun highScoreRows[RECORD_HIGH_SCORES] = {0}; // Keyed by version
+static TextureAsset backgroundAsset = {"background.jpg", SCREEN_WIDTH,
+                                       SCREEN_HEIGHT};
+static Material shapeMaterial = {0};      // Default shader, vertex colors
+static Mesh wallMesh = {0};               // Static bricks, one draw call
+static int wallMeshCapacity = 0;          // Vertices the wall buffers hold
+static RenderTexture2D staticLayer = {0}; // Background and static bricks
+static RenderTexture2D sceneTarget = {0}; // Frame at the internal resolution
+static Camera2D sceneCamera = {0};        // Logical units to target pixels
+static Rectangle presentRect = {0};       // Letterboxed scene in the window
+static float outputScale = 1.0f;          // Window pixels per logical unit
+static RenderScaler scaler = {1.0f, 0.0f, 0.0f, SCALE_SETTLE_TIME, 0.0f,
+                              SCALE_PROBE_DELAY, false};
+static bool wallDirty = true; // Static bricks changed since the last draw
+static unsigned int renderedWallVersion = 0; // wallVersion last drawn
+static Mesh paddleMesh = {0};             // Paddle at the origin
+static Mesh particleMesh = {0};           // Every particle, one draw call
+static float paddleMeshWidth = 0.0f;      // Width paddleMesh was built for
+static GameState currentState = GameState::MENU; // As of the latest snapshot
 static bool paused = false;
-static int activeBricks = 0;
-static float countdownTimer = 0.0f;
-static Difficulty currentDifficulty = Difficulty::EASY;
-static int currentLevel = 1;
 static int selectedMenuOption = 0;
 static std::random_device rd; // Hardware entropy source
-static std::mt19937 rng(rd() ^
-                        static_cast<unsigned int>(GetTime())); // Enhanced seed
+static bool useFixedSeed = false; // --seed given: every game replays the same
+static uint64_t fixedSeed = 0;
+static Replay playback;                      // Loaded --replay file
+static ReplayCursor playbackCursor = {0};    // Position in playback
+static const char *recordFileName = nullptr; // --record target, if any
+static bool playingReplay = false;           // Ticks come from playback
+static LevelPack levelPack = {0};            // --levels, mapped for the run
+static int wallRows = 0;                     // --wall grid, 0 for classic
+static int wallCols = 0;
+static UdpSocket broadcastSocket = {-1};     // --broadcast target, if any
+static NetEncoder netEncoder = {0};          // Simulation thread only
+static NetPacket netPacket = {0};            // Simulation thread only
+static std::atomic<unsigned int> netSkipped(0); // Ticks not sent, sim -> main
+static int unstreamedLevel = 0; // Last level reported too large, sim only
+static UdpSocket spectateSocket = {-1};      // --spectate: watch, don't play
+static NetDecoder netDecoder = {0};
+static FrameSnapshot spectatorFrame = {0};   // Latest received tick
+static bool profilerOverlay = false;         // F1: zone timings on screen
+static HudText hudText = {0};
+static StaticText staticText = {0};
+static TextRun hitLabels[LEVEL_CELL_HITS + 1] = {0}; // By hits, from 2
+static TextRun powerUpLabels[5] = {0};               // By PowerUpType
+static ParticlePool particles;  // Main thread only
 
 //------------------------------------------------------------------------------------
 // Module Functions Declaration
 //------------------------------------------------------------------------------------
-static void InitGame();
+static void InitGame(Difficulty diff);
 static void UpdateGame();
-static void DrawGame();
+static void StartSimulation();
+static void StopSimulation();
+static void SimulationThread();
+static bool SimulateTick(double tickEnd);
+static void StepPlayback(uint8_t input);
+static void PublishSnapshot(double tickTime);
+static double GetClockTime();
+static void FinishRecording();
+static void RecordGame();
+static void BroadcastTick();
+static bool OpenBroadcast(const char *target);
+static void UpdateSpectator();
+static void UpdateProfiler();
+static void LoadGameAssets();
+static void DrawGame(const FrameSnapshot &frame, float alpha);
 static void UnloadGame();
 static void UpdateDrawFrame();
-static void ResetBallsAndPaddle();
-static void SetupLevel(Difficulty diff);
 static void UpdateMenu();
+static void StartAutopilotGame();
+static uint8_t GetAutopilotInput(uint8_t pressed);
+static bool IsAnyInputPressed();
+static void StartStressTest();
+static void BeginStressStage(int balls);
+static void UpdateStressTest();
+static float GetPercentile(const std::vector<float> &sorted, float fraction);
+static uint8_t GetHeldInput();
+static void ClearInput();
 static void DrawMenu();
-static void SpawnPowerUp(Vector2 position);
-static void UpdatePowerUps();
-static void ApplyPowerUp(PowerUpType type);
-static bool HandleBrickCollision(Ball &ball);
+static void DrawSpectatorWaiting();
+static void LoadTextCache();
+static void DrawCenteredText(const TextRun &text, int y, Color color);
+static void DrawHitLabel(Rectangle brickRect, int hits);
+static void LoadRenderCache();
+static void UnloadRenderCache();
+static void LoadRenderTargets();
+static void UnloadRenderTargets();
+static void SetRenderScale(float scale);
+static void UpdateRenderScale();
+static Rectangle GetSceneSource(const RenderTexture2D &target);
+static void BeginScene();
+static void EndScene();
+static int AppendRoundedRect(Mesh &mesh, int vertex, Rectangle rec,
+                             float roundness, int segments, Color color);
+static int GetBrickSegments(const BrickStore &bricks);
+static void ReserveWallMesh(int vertexCount);
+static void RebuildWallMesh(const BrickStore &bricks);
+static void RenderStaticLayer(const BrickStore &bricks);
+static void DrawBackground();
+static void DrawStaticBricks(const BrickStore &bricks);
+static void DrawMovingBricks(const BrickStore &bricks, float alpha);
+static void DrawPaddle(const Paddle &paddle, float alpha);
+static const FrameSnapshot &LatchFrame(const FrameSnapshot &frame,
+                                       float &alpha);
+static void MeasureInputLatency();
+static void DrawPowerUps(const GameSnapshot &game, float alpha);
+static void DrawBalls(const GameSnapshot &game, float alpha);
+static void DrawBallTrails(const GameSnapshot &game);
+static void DrawParticles(const FrameSnapshot &frame);
+static void PlayGameEvents(const FrameSnapshot &frame);
+static void ClearGameEvents();
+static void DrawHud(const FrameSnapshot &frame);
+static void DrawProfilerOverlay();
+static float Interpolate(float previous, float current, float alpha);
+
+//------------------------------------------------------------------------------------
+// Allocation counting
+//------------------------------------------------------------------------------------
+void *operator new(std::size_t size) {
+  CountProfileEvent(PROFILE_ALLOCATIONS);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
 
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main() {
-  InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "PIP Breakout");
-  SetTargetFPS(60);
+int main(int argc, char **argv) {
+  const char *replayFileName = nullptr;
+  const char *broadcastTarget = nullptr;
+  const char *levelsFileName = nullptr;
+  const char *musicFileName = nullptr;
+  int spectatePort = 0;
+  int windowWidth = SCREEN_WIDTH;
+  int windowHeight = SCREEN_HEIGHT;
+  bool fullscreen = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      useFixedSeed = true;
+      fixedSeed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordFileName = argv[++i];
+    } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayFileName = argv[++i];
+    } else if (std::strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+      broadcastTarget = argv[++i];
+    } else if (std::strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+      spectatePort = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+      levelsFileName = argv[++i];
+    } else if (std::strcmp(argv[i], "--wall") == 0 && i + 1 < argc) {
+      std::sscanf(argv[++i], "%dx%d", &wallRows, &wallCols);
+    } else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+      std::sscanf(argv[++i], "%dx%d", &windowWidth, &windowHeight);
+    } else if (std::strcmp(argv[i], "--fullscreen") == 0) {
+      fullscreen = true;
+    } else if (std::strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+      scaler.fixedScale = static_cast<float>(std::atof(argv[++i]));
+    } else if (std::strcmp(argv[i], "--music") == 0 && i + 1 < argc) {
+      musicFileName = argv[++i];
+    } else if (std::strcmp(argv[i], "--mouse") == 0) {
+      mouseInput = true;
+    } else if (std::strcmp(argv[i], "--autopilot") == 0 && i + 1 < argc) {
+      soakPlayer = FindPaddleController(argv[++i]);
+      if (soakPlayer == nullptr)
+        TraceLog(LOG_WARNING, "Failed to find autopilot %s.", argv[i]);
+    } else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+      std::sscanf(argv[++i], "%dx%d", &stressBalls, &stressPowerUps);
+    }
+  }
+
+  // Decoding overlaps window creation and the first menu frames
+  StartAssetLoader(&backgroundAsset, 1);
+  // The window may have any size: the logical screen is scaled into it. A
+  // 0x0 fullscreen window takes the monitor's resolution.
+  SetConfigFlags(FLAG_WINDOW_RESIZABLE |
+                 (fullscreen ? FLAG_FULLSCREEN_MODE : 0));
+  InitWindow(fullscreen ? 0 : std::max(windowWidth, 1),
+             fullscreen ? 0 : std::max(windowHeight, 1), "PIP Breakout");
+  SetTargetFPS(TARGET_FPS);
   SetWindowState(FLAG_VSYNC_HINT);
+  if (mouseInput)
+    DisableCursor(); // Unbounded relative motion, as a spinner reports it
+  if (!InitGameAudio(musicFileName))
+    TraceLog(LOG_WARNING, "Failed to open the audio device, playing silent.");
+  OpenRecordStore(RECORDS_FILE);
+  LoadRenderTargets();
+  LoadTextCache();
+  ResetParticles(particles, rd());
+  if (scaler.fixedScale > 0.0f)
+    SetRenderScale(scaler.fixedScale);
 
   currentState = GameState::MENU;
   selectedMenuOption = 0;
 
-  while (!WindowShouldClose())
+  if (levelsFileName != nullptr) {
+    if (OpenLevelPack(levelPack, levelsFileName, MAX_GRID_ROWS,
+                      MAX_GRID_COLS)) {
+      TraceLog(LOG_INFO, "GAME: Playing %i levels from %s",
+               levelPack.levelCount, levelsFileName);
+    } else {
+      TraceLog(LOG_WARNING, "Failed to open level pack %s.", levelsFileName);
+    }
+  }
+
+  if (wallRows < 0 || wallRows > MAX_GRID_ROWS || wallCols < 0 ||
+      wallCols > MAX_GRID_COLS || (wallRows == 0) != (wallCols == 0)) {
+    TraceLog(LOG_WARNING, "Failed to use wall %ix%i. Up to %ix%i is allowed.",
+             wallRows, wallCols, MAX_GRID_ROWS, MAX_GRID_COLS);
+    wallRows = 0;
+    wallCols = 0;
+  }
+
+  if (broadcastTarget != nullptr && !OpenBroadcast(broadcastTarget))
+    TraceLog(LOG_WARNING, "Failed to open broadcast to %s.", broadcastTarget);
+
+  if (spectatePort > 0) {
+    if (OpenUdpReceiver(spectateSocket, spectatePort)) {
+      LoadGameAssets();
+      TraceLog(LOG_INFO, "GAME: Spectating on port %i", spectatePort);
+    } else {
+      TraceLog(LOG_WARNING, "Failed to listen on port %i.", spectatePort);
+    }
+  } else if (replayFileName != nullptr) {
+    const uint32_t packHash =
+        (levelPack.data != nullptr) ? HashLevelPack(levelPack) : 0;
+    if (!LoadReplay(playback, replayFileName)) {
+      TraceLog(LOG_WARNING, "Failed to load replay %s.", replayFileName);
+    } else if (playback.packHash != packHash) {
+      TraceLog(LOG_WARNING,
+               "Failed to play replay %s, it needs the level pack it was "
+               "recorded with.",
+               replayFileName);
+    } else {
+      playingReplay = true;
+      InitGame(playback.difficulty);
+    }
+  } else if (stressBalls > 0) {
+    StartStressTest();
+  } else if (soakPlayer != nullptr) {
+    StartAutopilotGame();
+  }
+
+  while (!WindowShouldClose() && !stressFinished)
     UpdateDrawFrame();
 
   UnloadGame();
@@ -145,592 +441,1396 @@ int main() {
 // Module Functions Definitions
 //------------------------------------------------------------------------------------
 
-void InitGame() {
-  score = 0;
-  lives = 3;
-  currentLevel = 1;
+// Start a new session at diff, or the loaded replay, and begin simulating it
+void InitGame(Difficulty diff) {
+  StopSimulation();
+  FinishRecording();
+  LoadGameAssets();
+  unstreamedLevel = 0; // A new game warns again about its first large wall
+  session.world.levelPack = levelPack.data != nullptr ? &levelPack : nullptr;
+  session.world.wallRows = wallRows;
+  session.world.wallCols = wallCols;
+
+  autopilot = nullptr;
+  if (playingReplay) {
+    // The pack was checked against the replay when it was loaded
+    StartSession(session, playback.difficulty, playback.seed, false);
+    StartReplay(session.world, playback, playbackCursor);
+  } else {
+    autopilot = (soakPlayer != nullptr) ? soakPlayer
+                : attractMode           ? InterceptBall
+                                        : nullptr;
+    // Fresh entropy gives a unique layout on every launch unless a seed was
+    // given on the command line
+    const uint64_t seed =
+        useFixedSeed ? fixedSeed
+                     : (static_cast<uint64_t>(rd()) << 32 | rd()) ^
+                           static_cast<uint64_t>(GetTime() * 1000.0);
+    StartSession(session, diff, seed,
+                 recordFileName != nullptr && !attractMode &&
+                     stressBalls == 0);
+    TraceLog(LOG_INFO, "GAME: Seed %llu",
+             static_cast<unsigned long long>(seed));
+  }
+
+  recordingGame = !playingReplay && stressBalls == 0;
+  gameFrameTimes = {0};
+  gamePowerUps = 0;
+  ClearGameEvents();
+  ClearInput();
+  ResetParticles(particles, rd());
+  currentState = GameState::PLAYING;
   paused = false;
-  powerUps.clear();
-  balls.clear();
+  PublishSnapshot(GetClockTime());
+  StartSimulation();
+}
 
-  // Load background texture
-  if (backgroundTexture.id == 0) // Load only if not already loaded
-  {
-    backgroundTexture = LoadTexture("background.jpg");
-    if (backgroundTexture.id == 0) {
-      TraceLog(LOG_WARNING,
-               "Failed to load background texture. Using default background.");
-    }
+void UpdateMenu() {
+  menuIdleTime = IsAnyInputPressed() ? 0.0f : menuIdleTime + GetFrameTime();
+  if (menuIdleTime >= ATTRACT_IDLE_TIME) {
+    attractMode = true;
+    StartAutopilotGame();
+    return;
   }
 
-  // Reseed RNG with fresh entropy for unique layout on every launch
-  rng.seed(rd() ^ static_cast<unsigned int>(GetTime()));
-  SetupLevel(currentDifficulty);
-}
-
-void SetupLevel(Difficulty diff) {
-  powerUpSpawnChance = (diff == Difficulty::EASY)     ? 0.2f
-                       : (diff == Difficulty::MEDIUM) ? 0.3f
-                                                      : 0.4f;
-  paddle.rect.width = (diff == Difficulty::EASY)     ? PADDLE_WIDTH * 1.5f
-                      : (diff == Difficulty::MEDIUM) ? PADDLE_WIDTH * 0.7f
-                                                     : PADDLE_WIDTH * 0.5f;
-  paddle.rect.height = PADDLE_HEIGHT;
-  paddle.rect.x = (SCREEN_WIDTH - paddle.rect.width) / 2.0f;
-  paddle.rect.y = SCREEN_HEIGHT - paddle.rect.height - 30.0f;
-  paddle.color = LIGHTGRAY; // Changed to LIGHTGRAY
-
-  ResetBallsAndPaddle();
-
-  activeBricks = 0;
-  const int initialOffsetY = 50;
-  const int activeRows = (diff == Difficulty::EASY)     ? BRICK_ROWS - 3
-                         : (diff == Difficulty::MEDIUM) ? BRICK_ROWS - 1
-                                                        : BRICK_ROWS;
-
-  std::vector<std::pair<int, int>> positions;
-  for (int i = 0; i < activeRows; i++)
-    for (int j = 0; j < BRICKS_PER_ROW; j++)
-      positions.emplace_back(i, j);
-
-  std::shuffle(positions.begin(), positions.end(), rng);
-  const int maxBricks = positions.size();
-  const int numBricks = maxBricks * (GetRandomValue(70, 90) / 100.0f);
-
-  for (int i = 0; i < BRICK_ROWS; i++) {
-    for (int j = 0; j < BRICKS_PER_ROW; j++) {
-      bricks[i][j] = {0};
-      bricks[i][j].rect.width = BRICK_WIDTH - BRICK_SPACING;
-      bricks[i][j].rect.height = BRICK_HEIGHT - BRICK_SPACING;
-      bricks[i][j].rect.x = j * BRICK_WIDTH + BRICK_SPACING / 2.0f;
-      bricks[i][j].rect.y =
-          initialOffsetY + i * BRICK_HEIGHT + BRICK_SPACING / 2.0f;
-      bricks[i][j].active = false;
+  if (IsKeyPressed(KEY_UP))
+    selectedMenuOption =
+        (selectedMenuOption - 1 + DIFFICULTY_COUNT) % DIFFICULTY_COUNT;
+  if (IsKeyPressed(KEY_DOWN))
+    selectedMenuOption = (selectedMenuOption + 1) % DIFFICULTY_COUNT;
+
+  if (IsKeyPressed(KEY_ENTER))
+    InitGame(static_cast<Difficulty>(selectedMenuOption));
+}
+
+// Soak and attract mode games cycle through the difficulties
+void StartAutopilotGame() {
+  const Difficulty diff =
+      static_cast<Difficulty>(autopilotGames++ % DIFFICULTY_COUNT);
+  TraceLog(LOG_INFO, "GAME: Autopilot game %i (%s)", autopilotGames,
+           GetDifficultyConfig(diff).name);
+  InitGame(diff);
+}
+
+// Forward input to the simulation thread and follow the session it reports
+void UpdateGame() {
+  if (currentState == GameState::MENU) {
+    UpdateMenu();
+    return;
+  }
+
+  // Only changes are queued, stamped with the time the devices were read.
+  // Anything ends a demo.
+  const uint8_t held = attractMode ? 0 : GetHeldInput();
+  uint8_t pressed = 0;
+  if (IsKeyPressed(KEY_P))
+    pressed |= REPLAY_PAUSE;
+  if (IsKeyPressed(KEY_B))
+    pressed |= REPLAY_MENU;
+  if (IsKeyPressed(KEY_ENTER))
+    pressed |= REPLAY_NEXT_LEVEL;
+  if (attractMode && IsAnyInputPressed())
+    pressed = REPLAY_MENU;
+  if ((held != sentHeld || pressed != 0) &&
+      inputSamples.Push({inputPollTime, held, pressed}))
+    sentHeld = held;
+
+  // The thread publishes the menu state as its last snapshot, then exits
+  const FrameSnapshot &frame = snapshots.Latest();
+  currentState = frame.state;
+  paused = frame.paused;
+  if (currentState == GameState::MENU) {
+    StopSimulation();
+    FinishRecording();
+    RecordGame();
+    if (autopilot != nullptr) {
+      TraceLog(LOG_INFO, "GAME: Autopilot game %i ended at level %i, score %i",
+               autopilotGames, frame.level, frame.game.score);
     }
+    playingReplay = false;
+    attractMode = false;
+    menuIdleTime = 0.0f;
+    selectedMenuOption = 0;
+    paused = false;
+    stressFinished = stress.balls > 0;
+    if (soakPlayer != nullptr && !stressFinished)
+      StartAutopilotGame();
   }
+  SetMusicPaused(paused);
+}
 
-  for (int k = 0; k < numBricks && k < static_cast<int>(positions.size());
-       k++) {
-    int i = positions[k].first;
-    int j = positions[k].second;
-    bricks[i][j].active = true;
-    if (diff == Difficulty::EASY)
-      bricks[i][j].hitsRequired = 1;
-    else if (diff == Difficulty::MEDIUM)
-      bricks[i][j].hitsRequired = GetRandomValue(1, 2);
-    else
-      bricks[i][j].hitsRequired = GetRandomValue(1, 3);
-    bricks[i][j].moveSpeed = (diff == Difficulty::HARD && i == activeRows - 1 &&
-                              GetRandomValue(0, 100) < 30)
-                                 ? 2.0f
-                                 : 0.0f;
-    bricks[i][j].color =
-        (bricks[i][j].hitsRequired == 1) ? Color{0, 255, 255, 255}
-                                         : // Neon cyan
-            (bricks[i][j].hitsRequired == 2) ? Color{255, 0, 255, 255}
-                                             : // Neon purple
-            Color{0, 255, 0, 255};             // Neon green
-    activeBricks++;
-  }
-
-  countdownTimer = (diff == Difficulty::EASY)     ? TIME_LIMIT_EASY
-                   : (diff == Difficulty::MEDIUM) ? TIME_LIMIT_MEDIUM
-                                                  : TIME_LIMIT_HARD;
-}
-
-void ResetBallsAndPaddle() {
-  paddle.rect.x = (SCREEN_WIDTH - paddle.rect.width) / 2.0f;
-  paddle.rect.y = SCREEN_HEIGHT - paddle.rect.height - 30.0f;
-
-  balls.clear();
-  Ball newBall = {0};
-  newBall.position = {paddle.rect.x + paddle.rect.width / 2.0f,
-                      paddle.rect.y - BALL_RADIUS - 5.0f};
-  newBall.radius = BALL_RADIUS;
-  newBall.color = WHITE;
-  newBall.hasCollided = false;
-  const float baseSpeedX =
-      (currentDifficulty == Difficulty::EASY)     ? INITIAL_BALL_SPEED_X * 0.8f
-      : (currentDifficulty == Difficulty::MEDIUM) ? INITIAL_BALL_SPEED_X * 1.2f
-                                                  : INITIAL_BALL_SPEED_X * 1.5f;
-  newBall.speed.x = baseSpeedX * (GetRandomValue(0, 1) ? 1.0f : -1.0f);
-  newBall.speed.y =
-      (currentDifficulty == Difficulty::EASY)     ? INITIAL_BALL_SPEED_Y * 0.8f
-      : (currentDifficulty == Difficulty::MEDIUM) ? INITIAL_BALL_SPEED_Y * 1.2f
-                                                  : INITIAL_BALL_SPEED_Y * 1.5f;
-  newBall.active = true;
-  balls.push_back(newBall);
-}
-
-void SpawnPowerUp(Vector2 position) {
-  if (GetRandomValue(0, 100) / 100.0f > powerUpSpawnChance)
+// The autopilot's paddle with the player's [P] and [B]. Result screens move
+// on by themselves after AUTOPILOT_RESULT_TICKS.
+uint8_t GetAutopilotInput(uint8_t pressed) {
+  if (session.state != GameState::PLAYING) {
+    if (++resultTicks >= AUTOPILOT_RESULT_TICKS)
+      return REPLAY_NEXT_LEVEL;
+    return pressed & REPLAY_MENU;
+  }
+  resultTicks = 0;
+  return GetReplayInput(autopilot(session.world).paddleMove) |
+         (pressed & (REPLAY_PAUSE | REPLAY_MENU));
+}
+
+// A key, the first gamepad's face buttons or a mouse button went down
+bool IsAnyInputPressed() {
+  if (GetKeyPressed() != 0 || IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    return true;
+  for (int button = GAMEPAD_BUTTON_RIGHT_FACE_UP;
+       button <= GAMEPAD_BUTTON_RIGHT_FACE_LEFT; button++) {
+    if (IsGamepadButtonPressed(0, button))
+      return true;
+  }
+  return false;
+}
+
+// Play one level with 1, 2, 4 ... stressBalls balls in turn, each for
+// STRESS_STAGE_TIME, and print what every count cost
+void StartStressTest() {
+  stressPowerUps = std::max(stressPowerUps, 0);
+  if (stressBalls > BALL_POOL_SIZE) {
+    TraceLog(LOG_INFO,
+             "GAME: Stress test over %i balls, build with -DBALL_POOL_SIZE=n "
+             "for more",
+             BALL_POOL_SIZE);
+  }
+  stress.frameTimes.reserve(STRESS_FRAME_SAMPLES);
+  std::printf("%7s %7s %7s %9s %9s %9s %9s %9s %10s %10s %9s %9s %9s\n",
+              "balls", "in play", "frames", "frame p50", "frame p99",
+              "frame max", "tick p50", "tick p99", "cells/fr", "sweeps/fr",
+              "refused", "cut/fr", "alloc p99");
+  InitGame(Difficulty::EASY);
+  BeginStressStage(1);
+}
+
+void BeginStressStage(int balls) {
+  const FrameSnapshot &frame = snapshots.Latest();
+  stress.balls = balls;
+  stress.startTime = GetClockTime();
+  stress.startStats = frame.game.stats;
+  stress.startTick = frame.game.tickCount;
+  stress.startRefused = stressRefused.load();
+  stress.startDropped = particles.dropped;
+  stress.frameTimes.clear();
+  stressBallTarget.store(balls);
+}
+
+// Sample the frame just presented and close the stage once it has run. Tick
+// times and allocations come from the profiler's rolling history, which the
+// stage outlasts.
+void UpdateStressTest() {
+  if (stress.balls == 0 || stressFinished)
+    return;
+  if (stress.frameTimes.size() < STRESS_FRAME_SAMPLES)
+    stress.frameTimes.push_back(GetFrameTime());
+  if (GetClockTime() - stress.startTime < STRESS_STAGE_TIME)
+    return;
+
+  const FrameSnapshot &frame = snapshots.Latest();
+  std::vector<float> &times = stress.frameTimes;
+  std::sort(times.begin(), times.end());
+  const float frames = static_cast<float>(std::max<size_t>(times.size(), 1));
+  const unsigned int ticks = frame.game.tickCount - stress.startTick;
+  const ProfileStats tick = GetProfileZoneStats(PROFILE_SIM_TICK);
+  std::printf("%7i %7i %7i %9.2f %9.2f %9.2f %9.3f %9.3f %10.1f %10.1f %9.1f "
+              "%9.1f %9.0f\n",
+              stress.balls, frame.game.balls.size(),
+              static_cast<int>(times.size()),
+              GetPercentile(times, 0.5f) * 1000.0f,
+              GetPercentile(times, 0.99f) * 1000.0f,
+              times.empty() ? 0.0f : times.back() * 1000.0f, tick.p50,
+              tick.p99,
+              (frame.game.stats.broadphaseTests -
+               stress.startStats.broadphaseTests) /
+                  frames,
+              (frame.game.stats.sweepTests - stress.startStats.sweepTests) /
+                  frames,
+              (stressRefused.load() - stress.startRefused) /
+                  static_cast<float>(std::max(ticks, 1u)),
+              (particles.dropped - stress.startDropped) / frames,
+              GetProfileCounterStats(PROFILE_ALLOCATIONS).p99);
+  std::fflush(stdout);
+  if (stress.balls < stressBalls) {
+    BeginStressStage(std::min(stress.balls * 2, stressBalls));
     return;
+  }
 
-  PowerUp powerUp = {0};
-  powerUp.rect = {position.x, position.y, POWERUP_SIZE, POWERUP_SIZE};
-  powerUp.active = true;
+  StopSimulation();
+  std::printf("memory: %zu bytes per session, %zu in snapshots, %zu in "
+              "particles, for pools of %i balls and %i power-ups\n",
+              GetSessionMemoryUsage(session), sizeof(snapshots),
+              sizeof(particles), BALL_POOL_SIZE, POWERUP_POOL_SIZE);
+  stressFinished = true;
+}
 
-  const int type = GetRandomValue(1, 4);
-  powerUp.type = static_cast<PowerUpType>(type);
-  switch (powerUp.type) {
-  case PowerUpType::PADDLE_SIZE_UP:
-    powerUp.color = SKYBLUE;
-    break;
-  case PowerUpType::BALL_SPEED_UP:
-    powerUp.color = RED;
-    break;
-  case PowerUpType::EXTRA_LIFE:
-    powerUp.color = GREEN;
-    break;
-  case PowerUpType::MULTI_BALL:
-    powerUp.color = PURPLE;
-    break;
-  default:
-    powerUp.color = WHITE;
-    break;
+// Nearest-rank percentile of ascending samples, 0 when there are none
+float GetPercentile(const std::vector<float> &sorted, float fraction) {
+  if (sorted.empty())
+    return 0.0f;
+  const size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1));
+  return sorted[rank];
+}
+
+// Arrow keys, else the first gamepad's d-pad or stick, else with --mouse the
+// mouse or spinner
+uint8_t GetHeldInput() {
+  uint8_t keys = 0;
+  if (IsKeyDown(KEY_LEFT))
+    keys |= REPLAY_LEFT;
+  if (IsKeyDown(KEY_RIGHT))
+    keys |= REPLAY_RIGHT;
+  if (keys != 0)
+    return keys;
+
+  if (IsGamepadAvailable(0)) {
+    if (IsGamepadButtonDown(0, GAMEPAD_BUTTON_LEFT_FACE_LEFT))
+      return REPLAY_LEFT;
+    if (IsGamepadButtonDown(0, GAMEPAD_BUTTON_LEFT_FACE_RIGHT))
+      return REPLAY_RIGHT;
+    const float axis = GetGamepadAxisMovement(0, GAMEPAD_AXIS_LEFT_X);
+    if (std::fabs(axis) > GAMEPAD_DEADZONE)
+      return GetReplayInput(axis);
   }
 
-  powerUps.push_back(powerUp);
+  // Hold the speed the mouse moved at over the last frame. What the eighth
+  // steps round off is carried into the next frame, travel past full speed
+  // is lost against the paddle's limit.
+  const float reach = PADDLE_SPEED * GetFrameTime();
+  if (!mouseInput || reach <= 0.0f)
+    return 0;
+  const float travel = GetMouseDelta().x / outputScale + mouseCarry;
+  const uint8_t held = GetReplayInput(travel / reach);
+  mouseCarry = Clamp(travel - GetReplayGameInput(held).paddleMove * reach,
+                     -reach, reach);
+  return held;
 }
 
-void UpdatePowerUps() {
-  for (size_t i = 0; i < powerUps.size();) {
-    PowerUp &powerUp = powerUps[i];
-    if (!powerUp.active) {
-      powerUps.erase(powerUps.begin() + i);
-      continue;
-    }
+// Forget the input of an earlier game. The simulation thread is stopped.
+void ClearInput() {
+  InputSample sample;
+  while (inputSamples.Pop(sample)) {
+  }
+  simHeld = 0;
+  simInputTime = 0.0;
+  sentHeld = 0;
+  mouseCarry = 0.0f;
+  resultTicks = 0;
+  latchedInputTime = 0.0;
+  shownInputTime = 0.0;
+}
+
+void StartSimulation() {
+  if (simThread.joinable())
+    return;
+  simRunning.store(true);
+  simThread = std::thread(SimulationThread);
+}
 
-    powerUp.rect.y += POWERUP_SPEED;
+// Returns once the simulation thread has exited; session is then safe to use
+void StopSimulation() {
+  simRunning.store(false);
+  if (simThread.joinable())
+    simThread.join();
+}
 
-    if (CheckCollisionRecs(powerUp.rect, paddle.rect)) {
-      ApplyPowerUp(powerUp.type);
-      powerUp.active = false;
-    } else if (powerUp.rect.y > SCREEN_HEIGHT) {
-      powerUp.active = false;
+// Run fixed ticks against the wall clock and publish a snapshot after each
+// batch, until stopped or the session returns to the menu
+void SimulationThread() {
+  double previousTime = GetClockTime();
+  double accumulator = 0.0; // Unsimulated time carried between batches
+  double tickTime = previousTime;
+  while (simRunning.load(std::memory_order_relaxed)) {
+    const double now = GetClockTime();
+    accumulator += std::min(now - previousTime, (double)MAX_FRAME_TIME);
+    previousTime = now;
+
+    bool ticked = false;
+    bool advanced = false;
+    while (accumulator >= SIM_DT && session.state != GameState::MENU) {
+      advanced |= SimulateTick(now - accumulator + SIM_DT);
+      if (broadcastSocket.handle >= 0)
+        BroadcastTick();
+      accumulator -= SIM_DT;
+      ticked = true;
     }
+    // Keep the time of the last tick that moved anything, so a paused or
+    // finished world interpolates to rest instead of jittering
+    if (advanced)
+      tickTime = now - accumulator;
+    if (ticked)
+      PublishSnapshot(tickTime);
+    if (session.state == GameState::MENU)
+      return;
 
-    if (powerUp.active)
-      ++i;
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(SIM_DT - accumulator));
   }
 }
 
-void ApplyPowerUp(PowerUpType type) {
-  switch (type) {
-  case PowerUpType::PADDLE_SIZE_UP:
-    paddle.rect.width = std::min(paddle.rect.width * 1.2f, PADDLE_WIDTH * 2.0f);
-    paddle.rect.x = std::max(
-        0.0f, std::min(paddle.rect.x,
-                       static_cast<float>(SCREEN_WIDTH) - paddle.rect.width));
-    break;
-  case PowerUpType::BALL_SPEED_UP:
-    for (auto &ball : balls) {
-      ball.speed.x *= 1.2f;
-      ball.speed.y *= 1.2f;
-      if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
-        ball.speed.x =
-            (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
-      }
-    }
-    break;
-  case PowerUpType::EXTRA_LIFE:
-    lives++;
-    break;
-  case PowerUpType::MULTI_BALL:
-    for (int i = 0; i < 2 && !balls.empty(); i++) {
-      Ball newBall = balls[0];
-      newBall.speed.x *= (i == 0 ? -1.0f : 1.0f);
-      newBall.speed.y = -std::abs(newBall.speed.y);
-      newBall.active = true;
-      newBall.hasCollided = false;
-      balls.push_back(newBall);
+// Step the session by one tick with the input sampled before tickEnd and
+// queue its events. Returns true when the world was simulated.
+bool SimulateTick(double tickEnd) {
+  const unsigned int tickCount = session.world.tickCount;
+  uint8_t pressed = 0;
+  InputSample sample;
+  while (inputSamples.Front() != nullptr &&
+         inputSamples.Front()->time < tickEnd && inputSamples.Pop(sample)) {
+    simHeld = sample.held;
+    pressed |= sample.pressed;
+    simInputTime = sample.time;
+  }
+  const uint8_t input =
+      (autopilot != nullptr) ? GetAutopilotInput(pressed) : simHeld | pressed;
+  if (playingReplay) {
+    StepPlayback(input);
+  } else {
+    const int stressTarget = stressBallTarget.load();
+    if (stressTarget > 0) {
+      stressRefused.fetch_add(
+          HoldStressLoad(session, stressTarget, stressPowerUps));
     }
-    break;
-  default:
-    break;
+    StepSession(session, input);
   }
+  if (session.world.tickCount == tickCount)
+    return false;
+  for (const auto &event : session.world.events)
+    gameEvents.Push(event);
+  return true;
 }
 
-void UpdateMenu() {
-  if (IsKeyPressed(KEY_UP))
-    selectedMenuOption = (selectedMenuOption - 1 + 3) % 3;
-  if (IsKeyPressed(KEY_DOWN))
-    selectedMenuOption = (selectedMenuOption + 1) % 3;
+// Replay the next recorded tick. The player's keys only pause the playback,
+// stop it, or leave its result screen.
+void StepPlayback(uint8_t input) {
+  if (session.state != GameState::PLAYING || (input & REPLAY_MENU)) {
+    if (input & (REPLAY_NEXT_LEVEL | REPLAY_MENU))
+      session.state = GameState::MENU;
+    return;
+  }
+  if (input & REPLAY_PAUSE)
+    session.paused = !session.paused;
+  if (session.paused || StepReplay(session.world, playback, playbackCursor))
+    return;
+
+  const LevelStatus status = session.world.status;
+  session.state = (status == LevelStatus::LOST)      ? GameState::GAME_OVER
+                  : (status == LevelStatus::CLEARED) ? GameState::YOU_WIN
+                                                     : GameState::MENU;
+}
+
+void PublishSnapshot(double tickTime) {
+  FrameSnapshot &frame = snapshots.Back();
+  TakeSnapshot(session.world, frame.game);
+  frame.state = session.state;
+  frame.paused = session.paused;
+  frame.level = GetSessionLevel(session);
+  frame.tickTime = tickTime;
+  frame.inputTime = simInputTime;
+  snapshots.Publish();
+}
 
-  if (IsKeyPressed(KEY_ENTER)) {
-    currentDifficulty = static_cast<Difficulty>(selectedMenuOption);
-    InitGame();
-    currentState = GameState::PLAYING;
+// Seconds on a monotonic clock that both threads can read
+double GetClockTime() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Send the tick just simulated to spectators
+void BroadcastTick() {
+  if (EncodeNetPacket(netEncoder, session, netPacket)) {
+    SendUdp(broadcastSocket, netPacket.data, netPacket.size);
+    return;
+  }
+  netSkipped.fetch_add(1);
+  const int level = GetSessionLevel(session);
+  if (session.world.bricks.count > NET_MAX_BRICKS &&
+      level != unstreamedLevel) {
+    TraceLog(LOG_WARNING,
+             "Failed to stream level %i, its wall of %i bricks is over %i.",
+             level, session.world.bricks.count, NET_MAX_BRICKS);
+    unstreamedLevel = level;
   }
 }
 
-bool HandleBrickCollision(Ball &ball) {
-  if (ball.hasCollided)
+// target is HOST:PORT
+bool OpenBroadcast(const char *target) {
+  const char *colon = std::strrchr(target, ':');
+  if (colon == nullptr)
     return false;
+  const std::string host(target, colon - target);
+  return OpenUdpSender(broadcastSocket, host.c_str(), std::atoi(colon + 1));
+}
 
-  for (int i = 0; i < BRICK_ROWS; i++) {
-    for (int j = 0; j < BRICKS_PER_ROW; j++) {
-      if (bricks[i][j].active &&
-          CheckCollisionCircleRec(ball.position, ball.radius,
-                                  bricks[i][j].rect)) {
-        ball.hasCollided = true;
-
-        bricks[i][j].hitsRequired--;
-        if (bricks[i][j].hitsRequired <= 0) {
-          bricks[i][j].active = false;
-          activeBricks--;
-          score += 10;
-          SpawnPowerUp({bricks[i][j].rect.x + bricks[i][j].rect.width / 2,
-                        bricks[i][j].rect.y + bricks[i][j].rect.height / 2});
-        } else {
-          bricks[i][j].color =
-              (bricks[i][j].hitsRequired == 1) ? Color{0, 255, 255, 255}
-                                               : // Neon cyan
-                  (bricks[i][j].hitsRequired == 2) ? Color{255, 0, 255, 255}
-                                                   : // Neon purple
-                  Color{0, 255, 0, 255};             // Neon green
-        }
-
-        float leftOverlap =
-            (ball.position.x + ball.radius) - bricks[i][j].rect.x;
-        float rightOverlap = (bricks[i][j].rect.x + bricks[i][j].rect.width) -
-                             (ball.position.x - ball.radius);
-        float topOverlap =
-            (ball.position.y + ball.radius) - bricks[i][j].rect.y;
-        float bottomOverlap = (bricks[i][j].rect.y + bricks[i][j].rect.height) -
-                              (ball.position.y - ball.radius);
-
-        float minOverlap =
-            std::min({leftOverlap, rightOverlap, topOverlap, bottomOverlap});
-
-        if (minOverlap == leftOverlap) {
-          ball.speed.x = -std::abs(ball.speed.x);
-          ball.position.x = bricks[i][j].rect.x - ball.radius - 0.1f;
-        } else if (minOverlap == rightOverlap) {
-          ball.speed.x = std::abs(ball.speed.x);
-          ball.position.x = bricks[i][j].rect.x + bricks[i][j].rect.width +
-                            ball.radius + 0.1f;
-        } else if (minOverlap == topOverlap) {
-          ball.speed.y = -std::abs(ball.speed.y);
-          ball.position.y = bricks[i][j].rect.y - ball.radius - 0.1f;
-        } else {
-          ball.speed.y = std::abs(ball.speed.y);
-          ball.position.y = bricks[i][j].rect.y + bricks[i][j].rect.height +
-                            ball.radius + 0.1f;
-        }
-
-        if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
-          ball.speed.x =
-              (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
-        }
-
-        return true;
-      }
+// Apply every datagram that arrived since the last frame
+void UpdateSpectator() {
+  uint8_t buffer[NET_MAX_PACKET];
+  bool received = false;
+  int size = 0;
+  while ((size = ReceiveUdp(spectateSocket, buffer, sizeof(buffer))) >= 0)
+    received |= ApplyNetPacket(netDecoder, buffer, size);
+  for (const auto &event : netDecoder.events)
+    gameEvents.Push(event);
+  netDecoder.events.clear();
+  if (!received)
+    return;
+
+  spectatorFrame.game = netDecoder.game;
+  spectatorFrame.state = netDecoder.state;
+  spectatorFrame.paused = netDecoder.paused;
+  spectatorFrame.level = netDecoder.level;
+  spectatorFrame.tickTime = GetClockTime();
+  currentState = netDecoder.state;
+  paused = netDecoder.paused;
+  SetMusicPaused(paused);
+}
+
+// F1 toggles the overlay, F2 starts a capture or writes the running one out.
+// Timing stays on only while either needs it.
+void UpdateProfiler() {
+  if (IsKeyPressed(KEY_F1))
+    profilerOverlay = !profilerOverlay;
+  if (IsKeyPressed(KEY_F2)) {
+    if (!IsProfileCapturing()) {
+      StartProfileCapture();
+      TraceLog(LOG_INFO, "GAME: Profile capture started");
+    } else if (StopProfileCapture(PROFILE_CSV_FILE, PROFILE_TRACE_FILE)) {
+      TraceLog(LOG_INFO, "GAME: Profile written to %s and %s",
+               PROFILE_CSV_FILE, PROFILE_TRACE_FILE);
+    } else {
+      TraceLog(LOG_WARNING, "Failed to write profile capture.");
     }
   }
-  return false;
+  SetProfilerEnabled(profilerOverlay || IsProfileCapturing() ||
+                     stress.balls > 0);
 }
 
-void UpdateGame() {
+// The background arrives from the asset loader, see UpdateDrawFrame()
+void LoadGameAssets() { LoadRenderCache(); }
+
+// Write the session recorded so far to the --record file
+void FinishRecording() {
+  if (!session.recording)
+    return;
+  session.recording = false;
+  if (SaveReplay(session.replay, recordFileName)) {
+    TraceLog(LOG_INFO, "GAME: Replay saved to %s (%u ticks)", recordFileName,
+             GetReplayTickCount(session.replay));
+  } else {
+    TraceLog(LOG_WARNING, "Failed to save replay %s.", recordFileName);
+  }
+}
+
+// Queue the game that just ended for the record store. A game still on its
+// level counts as quit. The simulation thread is stopped.
+void RecordGame() {
+  if (!recordingGame)
+    return;
+  recordingGame = false;
+  const GameWorld &world = session.world;
+  const auto frameMs = [](float ms) {
+    return static_cast<uint16_t>(std::min(ms * 100.0f, 65535.0f));
+  };
+  GameRecord record = {0};
+  record.endTime = static_cast<int64_t>(std::time(nullptr));
+  record.seed = world.seed;
+  record.score = world.score;
+  record.level = static_cast<uint16_t>(world.level);
+  record.difficulty = static_cast<uint8_t>(session.startDifficulty);
+  record.outcome = (world.status == LevelStatus::LOST)      ? RECORD_LOST
+                   : (world.status == LevelStatus::CLEARED) ? RECORD_WON
+                                                            : RECORD_QUIT;
+  record.autopilot = autopilot != nullptr;
+  record.ticks = world.tickCount;
+  record.powerUps = static_cast<uint16_t>(gamePowerUps);
+  record.frameP50 = frameMs(GetFrameTimePercentile(gameFrameTimes, 0.5f));
+  record.frameP99 = frameMs(GetFrameTimePercentile(gameFrameTimes, 0.99f));
+  record.frameMax = frameMs(gameFrameTimes.maxMs);
+  AppendGameRecord(record);
+}
+
+void DrawMenu() {
+  DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.5f));
+  DrawCenteredText(staticText.title, SCREEN_HEIGHT / 2 - 120, WHITE);
+  for (int option = 0; option < DIFFICULTY_COUNT; option++) {
+    DrawCenteredText(staticText.menuOptions[option],
+                     SCREEN_HEIGHT / 2 - 20 + option * 40,
+                     (selectedMenuOption == option) ? YELLOW : GRAY);
+  }
+  DrawCenteredText(staticText.menuHint, SCREEN_HEIGHT / 2 + 120, GRAY);
+
+  // Rows are laid out again only when the writer changed the table
+  GetHighScores(highScores);
+  if (highScores.count == 0)
+    return;
+  DrawCenteredText(staticText.highScores, SCREEN_HEIGHT / 2 + 170, WHITE);
+  for (int rank = 0; rank < highScores.count; rank++) {
+    const GameRecord &entry = highScores.entries[rank];
+    if (TextRunNeedsLayout(highScoreRows[rank], highScores.version)) {
+      LayoutTextRun(highScoreRows[rank],
+                    TextFormat("%i. %06i  %s  LEVEL %i", rank + 1, entry.score,
+                               GetDifficultyConfig(static_cast<Difficulty>(
+                                   entry.difficulty % DIFFICULTY_COUNT))
+                                   .name,
+                               entry.level),
+                    20, highScores.version);
+    }
+    DrawCenteredText(highScoreRows[rank], SCREEN_HEIGHT / 2 + 200 + rank * 24,
+                     GRAY);
+  }
+}
+
+// Lay out every fixed string and label once the default font is loaded
+void LoadTextCache() {
+  LayoutTextRun(staticText.title, "PIP BREAKOUT", 40);
+  for (int option = 0; option < DIFFICULTY_COUNT; option++)
+    LayoutTextRun(staticText.menuOptions[option],
+                  DIFFICULTY_CONFIGS[option].name, 30);
+  LayoutTextRun(staticText.menuHint, "Use UP/DOWN, ENTER to start", 20);
+  LayoutTextRun(staticText.backHint, "Press [B] for MENU", 20);
+  LayoutTextRun(staticText.paused, "PAUSED", 40);
+  LayoutTextRun(staticText.gameOver, "GAME OVER", 40);
+  LayoutTextRun(staticText.youWin, "YOU WIN!", 40);
+  LayoutTextRun(staticText.nextLevel, "Press [ENTER] for NEXT LEVEL", 20);
+  LayoutTextRun(staticText.toMenu, "Press [ENTER] to MENU", 20);
+  LayoutTextRun(staticText.waiting, "WAITING FOR BROADCAST...", 30);
+  LayoutTextRun(staticText.demo, "DEMO - Press any key", 20);
+  LayoutTextRun(staticText.highScores, "HIGH SCORES", 20);
+  for (int hits = 2; hits <= LEVEL_CELL_HITS; hits++)
+    LayoutTextRun(hitLabels[hits], TextFormat("%i", hits), 20);
+  LayoutTextRun(powerUpLabels[(int)PowerUpType::PADDLE_SIZE_UP], "P", 10);
+  LayoutTextRun(powerUpLabels[(int)PowerUpType::BALL_SPEED_UP], "S", 10);
+  LayoutTextRun(powerUpLabels[(int)PowerUpType::EXTRA_LIFE], "L", 10);
+  LayoutTextRun(powerUpLabels[(int)PowerUpType::MULTI_BALL], "M", 10);
+}
+
+void DrawCenteredText(const TextRun &text, int y, Color color) {
+  DrawTextRun(text, static_cast<float>(SCREEN_WIDTH / 2 - text.width / 2),
+              static_cast<float>(y), color);
+}
+
+// Centered near the top of the brick, as the wall has always shown them
+void DrawHitLabel(Rectangle brickRect, int hits) {
+  if (hits < 2 || hits > LEVEL_CELL_HITS)
+    return;
+  const TextRun &label = hitLabels[hits];
+  DrawTextRun(label, std::floor(brickRect.x + brickRect.width / 2) -
+                         label.width / 2,
+              std::floor(brickRect.y + 5), WHITE);
+}
+
+// Full frame shown by a spectator until a broadcast game is running
+void DrawSpectatorWaiting() {
+  BeginScene();
+  DrawBackground();
+  DrawCenteredText(staticText.waiting, SCREEN_HEIGHT / 2 - 15, GRAY);
+  EndScene();
+}
+
+// alpha is the fraction of a tick elapsed since the last simulation step,
+// used to interpolate moving objects between their previous and current state
+void DrawGame(const FrameSnapshot &frame, float alpha) {
+  const GameSnapshot &game = frame.game;
+  if (game.wallVersion != renderedWallVersion) {
+    renderedWallVersion = game.wallVersion;
+    wallDirty = true;
+  }
+
+  // The background and the static part of the wall are composed into
+  // staticLayer and redrawn only after a brick hit or a level setup
+  const bool useStaticLayer =
+      currentState != GameState::MENU && staticLayer.id > 0;
+  if (useStaticLayer && wallDirty)
+    RenderStaticLayer(game.bricks);
+
+  // frame goes stale once the game is latched, see LatchFrame()
+  const bool lastLevel = !game.hasNextLevel;
+  BeginScene();
+
+  if (useStaticLayer) {
+    // Rendered at the scene's scale, so this copies it pixel for pixel
+    DrawTexturePro(staticLayer.texture, GetSceneSource(staticLayer),
+                   {0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT},
+                   {0.0f, 0.0f}, 0.0f, WHITE);
+  } else {
+    DrawBackground();
+  }
+
   switch (currentState) {
   case GameState::MENU:
-    UpdateMenu();
+    DrawMenu();
     break;
 
-  case GameState::PLAYING: {
-    if (IsKeyPressed(KEY_P))
-      paused = !paused;
-
-    if (IsKeyPressed(KEY_B)) {
-      currentState = GameState::MENU;
-      selectedMenuOption = 0;
-      paused = false;
-      powerUps.clear();
-      return;
+  case GameState::PLAYING:
+  case GameState::GAME_OVER:
+  case GameState::YOU_WIN: {
+    float shownAlpha = alpha;
+    const FrameSnapshot &shown = LatchFrame(frame, shownAlpha);
+    DrawPaddle(shown.game.paddle, shownAlpha);
+    {
+      PROFILE_SCOPE(PROFILE_DRAW_BRICKS);
+      if (!useStaticLayer)
+        DrawStaticBricks(shown.game.bricks);
+      DrawMovingBricks(shown.game.bricks, shownAlpha);
     }
+    PlayGameEvents(shown);
+    DrawParticles(shown);
+    DrawPowerUps(shown.game, shownAlpha);
+    DrawBalls(shown.game, shownAlpha);
+    DrawHud(shown);
+    break;
+  }
+  }
 
-    if (paused)
-      return;
+  if (currentState == GameState::GAME_OVER) {
+    DrawRectangle(0, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH, 80,
+                  Fade(MATTE_BLACK, 0.7f));
+    DrawCenteredText(staticText.gameOver, SCREEN_HEIGHT / 2 - 20, RED);
+    DrawCenteredText(staticText.toMenu, SCREEN_HEIGHT / 2 + 25, WHITE);
+  } else if (currentState == GameState::YOU_WIN) {
+    DrawRectangle(0, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH, 80,
+                  Fade(MATTE_BLACK, 0.7f));
+    DrawCenteredText(staticText.youWin, SCREEN_HEIGHT / 2 - 20, GREEN);
+    DrawCenteredText(!lastLevel ? staticText.nextLevel : staticText.toMenu,
+                     SCREEN_HEIGHT / 2 + 25, WHITE);
+  }
 
-    countdownTimer -= GetFrameTime();
-    if (countdownTimer <= 0.0f) {
-      lives--;
-      for (auto &ball : balls)
-        ball.active = false;
-      if (lives <= 0)
-        currentState = GameState::GAME_OVER;
-      else
-        ResetBallsAndPaddle();
-    }
+  if (profilerOverlay)
+    DrawProfilerOverlay();
 
-    if (IsKeyDown(KEY_LEFT))
-      paddle.rect.x -= PADDLE_SPEED;
-    if (IsKeyDown(KEY_RIGHT))
-      paddle.rect.x += PADDLE_SPEED;
-    paddle.rect.x = std::max(
-        0.0f, std::min(paddle.rect.x,
-                       static_cast<float>(SCREEN_WIDTH) - paddle.rect.width));
-
-    bool anyBallActive = false;
-    for (auto &ball : balls) {
-      if (!ball.active)
-        continue;
-
-      anyBallActive = true;
-      ball.hasCollided = false;
-
-      // Update trail
-      ball.trail.push_front(ball.position);
-      if (ball.trail.size() > ball.maxTrailLength)
-        ball.trail.pop_back();
-
-      ball.position.x += ball.speed.x;
-      ball.position.y += ball.speed.y;
-
-      if (ball.position.x + ball.radius >= SCREEN_WIDTH ||
-          ball.position.x - ball.radius <= 0) {
-        ball.speed.x *= -1;
-        if (std::abs(ball.speed.x) < MIN_BALL_SPEED_X) {
-          ball.speed.x =
-              (ball.speed.x >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X);
-        }
-      }
-      if (ball.position.y - ball.radius <= 0)
-        ball.speed.y *= -1;
-
-      if (ball.position.y + ball.radius >= SCREEN_HEIGHT)
-        ball.active = false;
-
-      if (CheckCollisionCircleRec(ball.position, ball.radius, paddle.rect) &&
-          ball.speed.y > 0) {
-        const float shiftAmount = 0.3f;
-        const float speedMagnitude = std::sqrt(ball.speed.x * ball.speed.x +
-                                               ball.speed.y * ball.speed.y);
-        ball.speed.y = -std::abs(ball.speed.y);
-        const float hitPoint =
-            (ball.position.x - paddle.rect.x) / paddle.rect.width;
-        float targetSpeedX;
-        if (hitPoint < (0.5f - shiftAmount))
-          targetSpeedX = -speedMagnitude * 0.6f;
-        else if (hitPoint > (0.5f + shiftAmount))
-          targetSpeedX = speedMagnitude * 0.6f;
-        else
-          targetSpeedX = (hitPoint - 0.5f) * 2.0f * speedMagnitude * 0.5f;
-        if (std::abs(targetSpeedX) < MIN_BALL_SPEED_X) {
-          targetSpeedX =
-              (targetSpeedX >= 0 ? MIN_BALL_SPEED_X : -MIN_BALL_SPEED_X) *
-              (1.0f + GetRandomValue(-10, 10) / 100.0f);
-        }
-        ball.speed.x = targetSpeedX;
-        ball.position.y = paddle.rect.y - ball.radius - 0.1f;
-      }
+  EndScene();
+}
 
-      HandleBrickCollision(ball);
+void DrawPowerUps(const GameSnapshot &game, float alpha) {
+  PROFILE_SCOPE(PROFILE_DRAW_POWERUPS);
+  for (const auto &powerUp : game.powerUps) {
+    if (powerUp.active) {
+      Rectangle powerUpRect = powerUp.rect;
+      powerUpRect.y = Interpolate(powerUp.prevY, powerUp.rect.y, alpha);
+      DrawRectangleRec(powerUpRect, powerUp.color);
+      DrawTextRun(powerUpLabels[(int)powerUp.type],
+                  std::floor(powerUpRect.x + 5), std::floor(powerUpRect.y + 5),
+                  WHITE);
     }
+  }
+}
 
-    if (!anyBallActive) {
-      lives--;
-      if (lives <= 0)
-        currentState = GameState::GAME_OVER;
-      else
-        ResetBallsAndPaddle();
+void DrawBalls(const GameSnapshot &game, float alpha) {
+  PROFILE_SCOPE(PROFILE_DRAW_BALLS);
+  DrawBallTrails(game);
+  for (const auto &ball : game.balls) {
+    if (ball.active) {
+      const Vector2 ballPosition = {
+          Interpolate(ball.prevPosition.x, ball.position.x, alpha),
+          Interpolate(ball.prevPosition.y, ball.position.y, alpha)};
+      DrawCircleV(ballPosition, ball.radius, ball.color);
     }
+  }
+}
 
-    if (currentDifficulty == Difficulty::HARD) {
-      for (int i = 0; i < BRICK_ROWS; i++) {
-        for (int j = 0; j < BRICKS_PER_ROW; j++) {
-          if (bricks[i][j].active && bricks[i][j].moveSpeed != 0.0f) {
-            bricks[i][j].rect.x += bricks[i][j].moveSpeed;
-            if (bricks[i][j].rect.x <= 0 ||
-                bricks[i][j].rect.x + bricks[i][j].rect.width >= SCREEN_WIDTH) {
-              bricks[i][j].moveSpeed *= -1;
-            }
-          }
-        }
-      }
-    }
+// Score, lives, timer and level along the top, hints and pause at the bottom
+void DrawHud(const FrameSnapshot &frame) {
+  PROFILE_SCOPE(PROFILE_DRAW_HUD);
+  const GameSnapshot &game = frame.game;
+  if (TextRunNeedsLayout(hudText.score, game.score)) {
+    LayoutTextRun(hudText.score, TextFormat("SCORE: %04i", game.score), 20,
+                  game.score);
+  }
+  DrawTextRun(hudText.score, 10, 10, WHITE);
 
-    UpdatePowerUps();
+  if (TextRunNeedsLayout(hudText.lives, game.lives)) {
+    LayoutTextRun(hudText.lives, TextFormat("LIVES: %i", game.lives), 20,
+                  game.lives);
+  }
+  DrawTextRun(hudText.lives, SCREEN_WIDTH - 100, 10, WHITE);
+
+  const int secondsLeft = static_cast<int>(game.countdownTimer);
+  if (TextRunNeedsLayout(hudText.time, secondsLeft)) {
+    LayoutTextRun(hudText.time,
+                  TextFormat("TIME: %02i:%02i", secondsLeft / 60,
+                             secondsLeft % 60),
+                  20, secondsLeft);
+  }
+  DrawTextRun(hudText.time, SCREEN_WIDTH / 2 - 50, 10,
+              game.countdownTimer <= 10.0f ? RED : WHITE);
+
+  const int levelKey = frame.level * DIFFICULTY_COUNT + (int)game.difficulty;
+  if (TextRunNeedsLayout(hudText.level, levelKey)) {
+    LayoutTextRun(hudText.level,
+                  TextFormat("LEVEL: %i (%s)", frame.level,
+                             GetDifficultyConfig(game.difficulty).name),
+                  20, levelKey);
+  }
+  DrawTextRun(hudText.level, 10, 40, WHITE);
+  if (attractMode)
+    DrawCenteredText(staticText.demo, SCREEN_HEIGHT - 30, GRAY);
+  else
+    DrawTextRun(staticText.backHint, 10, SCREEN_HEIGHT - 30, GRAY);
+
+  if (paused && currentState == GameState::PLAYING)
+    DrawCenteredText(staticText.paused, SCREEN_HEIGHT / 2 - 20, GRAY);
+}
 
-    if (activeBricks <= 0)
-      currentState = GameState::YOU_WIN;
-    break;
+// Rolling p50/p99 of every profiled zone and counter under the HUD, then the
+// particles refused at the cap and the spectator ticks not sent
+void DrawProfilerOverlay() {
+  constexpr int x = SCREEN_WIDTH - 230;
+  constexpr int rowHeight = 12;
+  const int rows = PROFILE_ZONE_COUNT + PROFILE_COUNTER_COUNT + 5;
+  int y = 40;
+  DrawRectangle(x - 5, y - 5, 225, rows * rowHeight + 10, Fade(BLACK, 0.7f));
+  DrawText(TextFormat("%-12s %8s %8s", "zone (ms)", "p50", "p99"), x, y, 10,
+           YELLOW);
+  for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+    const ProfileStats stats = GetProfileZoneStats((ProfileZone)zone);
+    y += rowHeight;
+    DrawText(TextFormat("%-12s %8.3f %8.3f",
+                        GetProfileZoneName((ProfileZone)zone), stats.p50,
+                        stats.p99),
+             x, y, 10, WHITE);
   }
+  for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+    const ProfileStats stats =
+        GetProfileCounterStats((ProfileCounter)counter);
+    y += rowHeight;
+    DrawText(TextFormat("%-12s %8.0f %8.0f",
+                        GetProfileCounterName((ProfileCounter)counter),
+                        stats.p50, stats.p99),
+             x, y, 10, SKYBLUE);
+  }
+  y += rowHeight;
+  DrawText(TextFormat("%-12s %17u", "parts cut", particles.dropped), x, y, 10,
+           particles.dropped > 0 ? ORANGE : SKYBLUE);
+  y += rowHeight;
+  const unsigned int skipped = netSkipped.load();
+  DrawText(TextFormat("%-12s %17u", "net skipped", skipped), x, y, 10,
+           skipped > 0 ? ORANGE : SKYBLUE);
+  y += rowHeight;
+  DrawText(TextFormat("%-12s %8.2f %4ix%i", "render scale", scaler.scale,
+                      (int)(SCREEN_WIDTH * sceneCamera.zoom),
+                      (int)(SCREEN_HEIGHT * sceneCamera.zoom)),
+           x, y, 10, GREEN);
+  y += rowHeight;
+  DrawText(IsProfileCapturing() ? "[F2] stop capture" : "[F2] capture", x, y,
+           10, IsProfileCapturing() ? RED : GRAY);
+}
 
-  case GameState::GAME_OVER:
-  case GameState::YOU_WIN:
-    if (IsKeyPressed(KEY_ENTER)) {
-      if (currentState == GameState::YOU_WIN &&
-          currentDifficulty != Difficulty::HARD) {
-        currentLevel++;
-        currentDifficulty =
-            static_cast<Difficulty>(static_cast<int>(currentDifficulty) + 1);
-        SetupLevel(currentDifficulty);
-        score += 100;
-        currentState = GameState::PLAYING;
-      } else {
-        currentState = GameState::MENU;
-        selectedMenuOption = 0;
-      }
-      paused = false;
+float Interpolate(float previous, float current, float alpha) {
+  return previous + (current - previous) * alpha;
+}
+
+// Allocate the cached brick wall and paddle meshes (needs a GL context)
+void LoadRenderCache() {
+  if (wallMesh.vboId != nullptr) // Load only if not already loaded
+    return;
+
+  shapeMaterial = LoadMaterialDefault();
+
+  // The wall buffer starts sized for the classic grid, grows for larger
+  // walls and is refilled in place
+  ReserveWallMesh(MAX_BRICKS * RoundedRectVertexCount(BRICK_SEGMENTS));
+  wallDirty = true;
+
+  paddleMesh.vertexCount = RoundedRectVertexCount(PADDLE_SEGMENTS);
+  paddleMesh.triangleCount = paddleMesh.vertexCount / 3;
+  paddleMesh.vertices = static_cast<float *>(
+      MemAlloc(paddleMesh.vertexCount * 3 * sizeof(float)));
+  paddleMesh.texcoords = static_cast<float *>(
+      MemAlloc(paddleMesh.vertexCount * 2 * sizeof(float)));
+  paddleMesh.colors = static_cast<unsigned char *>(
+      MemAlloc(paddleMesh.vertexCount * 4 * sizeof(unsigned char)));
+  UploadMesh(&paddleMesh, true);
+  paddleMeshWidth = 0.0f;
+
+  // Two triangles per particle, refilled every frame
+  particleMesh.vertexCount = PARTICLE_CAPACITY * 6;
+  particleMesh.triangleCount = particleMesh.vertexCount / 3;
+  particleMesh.vertices = static_cast<float *>(
+      MemAlloc(particleMesh.vertexCount * 3 * sizeof(float)));
+  particleMesh.texcoords = static_cast<float *>(
+      MemAlloc(particleMesh.vertexCount * 2 * sizeof(float)));
+  particleMesh.colors = static_cast<unsigned char *>(
+      MemAlloc(particleMesh.vertexCount * 4 * sizeof(unsigned char)));
+  UploadMesh(&particleMesh, true);
+}
+
+void UnloadRenderCache() {
+  if (wallMesh.vboId == nullptr)
+    return;
+  UnloadMesh(wallMesh);
+  UnloadMesh(paddleMesh);
+  UnloadMesh(particleMesh);
+  UnloadMaterial(shapeMaterial);
+  wallMesh = {0};
+  wallMeshCapacity = 0;
+  paddleMesh = {0};
+  particleMesh = {0};
+  shapeMaterial = {0};
+}
+
+// Size the scene target and the static layer for the window. The logical
+// screen is letterboxed into it and rendered at up to its native pixel size.
+void LoadRenderTargets() {
+  const float windowWidth = static_cast<float>(GetScreenWidth());
+  const float windowHeight = static_cast<float>(GetScreenHeight());
+  if (windowWidth < 1.0f || windowHeight < 1.0f) // Minimized
+    return;
+  UnloadRenderTargets();
+
+  outputScale = std::min(windowWidth / SCREEN_WIDTH,
+                         windowHeight / SCREEN_HEIGHT);
+  const float width = SCREEN_WIDTH * outputScale;
+  const float height = SCREEN_HEIGHT * outputScale;
+  presentRect = {(windowWidth - width) / 2.0f, (windowHeight - height) / 2.0f,
+                 width, height};
+
+  // Allocated once at full size; lower scales draw into a corner of them
+  const int targetWidth = static_cast<int>(std::ceil(width));
+  const int targetHeight = static_cast<int>(std::ceil(height));
+  sceneTarget = LoadRenderTexture(targetWidth, targetHeight);
+  if (sceneTarget.id > 0) {
+    SetTextureFilter(sceneTarget.texture, TEXTURE_FILTER_BILINEAR);
+  } else {
+    TraceLog(LOG_WARNING,
+             "Failed to create scene target. Drawing at window resolution.");
+  }
+  staticLayer = LoadRenderTexture(targetWidth, targetHeight);
+  if (staticLayer.id == 0) {
+    TraceLog(LOG_WARNING,
+             "Failed to create static layer. Drawing the wall every frame.");
+  }
+  SetRenderScale(scaler.scale);
+  scaler.settleTime = SCALE_SETTLE_TIME;
+}
+
+void UnloadRenderTargets() {
+  if (sceneTarget.id > 0)
+    UnloadRenderTexture(sceneTarget);
+  if (staticLayer.id > 0)
+    UnloadRenderTexture(staticLayer);
+  sceneTarget = {0};
+  staticLayer = {0};
+}
+
+void SetRenderScale(float scale) {
+  scaler.scale = std::max(MIN_RENDER_SCALE, std::min(scale, 1.0f));
+  // Without a target the scene goes straight to the window at full size
+  if (sceneTarget.id > 0) {
+    sceneCamera.offset = {0.0f, 0.0f};
+    sceneCamera.zoom = outputScale * scaler.scale;
+  } else {
+    sceneCamera.offset = {presentRect.x, presentRect.y};
+    sceneCamera.zoom = outputScale;
+  }
+  wallDirty = true; // The static layer is drawn at the scene's scale
+}
+
+// Judge the last frame against FRAME_BUDGET. Frame time stands in for GPU
+// time: the main thread only draws, so a late frame means rendering is the
+// bottleneck.
+void UpdateRenderScale() {
+  if (scaler.fixedScale > 0.0f || sceneTarget.id == 0)
+    return;
+  const float frameTime = GetFrameTime();
+  if (scaler.settleTime > 0.0f) {
+    scaler.settleTime -= frameTime;
+    scaler.frameTime = FRAME_BUDGET;
+    return;
+  }
+  scaler.frameTime += (frameTime - scaler.frameTime) * FRAME_TIME_SMOOTHING;
+
+  if (scaler.frameTime > FRAME_BUDGET * FRAME_BUDGET_SLACK) {
+    if (scaler.scale <= MIN_RENDER_SCALE)
+      return;
+    if (scaler.probing) {
+      scaler.probeDelay =
+          std::min(scaler.probeDelay * 2.0f, MAX_SCALE_PROBE_DELAY);
     }
-    break;
+    scaler.probing = false;
+    SetRenderScale(scaler.scale - RENDER_SCALE_STEP);
+  } else {
+    scaler.onBudgetTime += frameTime;
+    if (scaler.onBudgetTime < scaler.probeDelay || scaler.scale >= 1.0f)
+      return;
+    if (scaler.probing) // The last step up held
+      scaler.probeDelay = SCALE_PROBE_DELAY;
+    scaler.probing = true;
+    SetRenderScale(scaler.scale + RENDER_SCALE_STEP);
   }
+  scaler.settleTime = SCALE_SETTLE_TIME;
+  scaler.onBudgetTime = 0.0f;
+  TraceLog(LOG_INFO, "GAME: Render scale %.1f (%ix%i)", scaler.scale,
+           static_cast<int>(SCREEN_WIDTH * sceneCamera.zoom),
+           static_cast<int>(SCREEN_HEIGHT * sceneCamera.zoom));
 }
 
-void DrawMenu() {
-  DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.5f));
-  DrawText("PIP BREAKOUT",
-           SCREEN_WIDTH / 2 - MeasureText("PIP BREAKOUT", 40) / 2,
-           SCREEN_HEIGHT / 2 - 120, 40, WHITE);
+// The corner of a full-size target that the scene covers at the current
+// scale. Render textures are stored bottom-up, so the rectangle is flipped.
+Rectangle GetSceneSource(const RenderTexture2D &target) {
+  const float width = SCREEN_WIDTH * sceneCamera.zoom;
+  const float height = SCREEN_HEIGHT * sceneCamera.zoom;
+  return {0.0f, target.texture.height - height, width, -height};
+}
+
+// Everything between BeginScene() and EndScene() is drawn in logical units
+void BeginScene() {
+  if (sceneTarget.id > 0)
+    BeginTextureMode(sceneTarget);
+  else
+    BeginDrawing();
+  ClearBackground(MATTE_BLACK);
+  BeginMode2D(sceneCamera);
+}
+
+// Upscale the scene into the window, with black bars where the aspect ratios
+// differ
+void EndScene() {
+  EndMode2D();
+  if (sceneTarget.id > 0) {
+    CountProfileEvent(PROFILE_DRAW_CALLS); // Scene batch flush
+    EndTextureMode();
+    BeginDrawing();
+    ClearBackground(BLACK);
+    DrawTexturePro(sceneTarget.texture, GetSceneSource(sceneTarget),
+                   presentRect, {0.0f, 0.0f}, 0.0f, WHITE);
+  }
+  PROFILE_SCOPE(PROFILE_PRESENT);
+  CountProfileEvent(PROFILE_DRAW_CALLS); // Final batch flush
+  EndDrawing();
+}
 
-  const Color easyColor = (selectedMenuOption == 0) ? YELLOW : GRAY;
-  const Color mediumColor = (selectedMenuOption == 1) ? YELLOW : GRAY;
-  const Color hardColor = (selectedMenuOption == 2) ? YELLOW : GRAY;
+// Write a rounded rectangle (same shape as DrawRectangleRounded) into the
+// mesh arrays starting at `vertex`; returns the next free vertex
+int AppendRoundedRect(Mesh &mesh, int vertex, Rectangle rec, float roundness,
+                      int segments, Color color) {
+  const float radius = (segments == 0) ? 0.0f
+                                       : std::min(rec.width, rec.height) *
+                                             std::min(roundness, 1.0f) / 2.0f;
+  auto emit = [&](float x, float y) {
+    mesh.vertices[vertex * 3 + 0] = x;
+    mesh.vertices[vertex * 3 + 1] = y;
+    mesh.vertices[vertex * 3 + 2] = 0.0f;
+    mesh.colors[vertex * 4 + 0] = color.r;
+    mesh.colors[vertex * 4 + 1] = color.g;
+    mesh.colors[vertex * 4 + 2] = color.b;
+    mesh.colors[vertex * 4 + 3] = color.a;
+    vertex++;
+  };
+  auto emitQuad = [&](float x, float y, float w, float h) {
+    emit(x, y);
+    emit(x, y + h);
+    emit(x + w, y + h);
+    emit(x, y);
+    emit(x + w, y + h);
+    emit(x + w, y);
+  };
+
+  emitQuad(rec.x + radius, rec.y, rec.width - 2 * radius, rec.height);
+  if (segments == 0)
+    return vertex;
+  emitQuad(rec.x, rec.y + radius, radius, rec.height - 2 * radius);
+  emitQuad(rec.x + rec.width - radius, rec.y + radius, radius,
+           rec.height - 2 * radius);
+
+  // Corner centers with the start angle of each quarter circle (y down)
+  const Vector2 centers[4] = {{rec.x + radius, rec.y + radius},
+                              {rec.x + rec.width - radius, rec.y + radius},
+                              {rec.x + rec.width - radius,
+                               rec.y + rec.height - radius},
+                              {rec.x + radius, rec.y + rec.height - radius}};
+  const float startAngles[4] = {180.0f, 270.0f, 0.0f, 90.0f};
+  const float step = 90.0f / segments * DEG2RAD;
+  for (int c = 0; c < 4; c++) {
+    float angle = startAngles[c] * DEG2RAD;
+    for (int k = 0; k < segments; k++) {
+      emit(centers[c].x, centers[c].y);
+      emit(centers[c].x + std::cos(angle + step) * radius,
+           centers[c].y + std::sin(angle + step) * radius);
+      emit(centers[c].x + std::cos(angle) * radius,
+           centers[c].y + std::sin(angle) * radius);
+      angle += step;
+    }
+  }
+  return vertex;
+}
 
-  DrawText("EASY", SCREEN_WIDTH / 2 - MeasureText("EASY", 30) / 2,
-           SCREEN_HEIGHT / 2 - 20, 30, easyColor);
-  DrawText("MEDIUM", SCREEN_WIDTH / 2 - MeasureText("MEDIUM", 30) / 2,
-           SCREEN_HEIGHT / 2 + 20, 30, mediumColor);
-  DrawText("HARD", SCREEN_WIDTH / 2 - MeasureText("HARD", 30) / 2,
-           SCREEN_HEIGHT / 2 + 60, 30, hardColor);
+// Corner segments for the bricks of this grid. Small bricks would not show
+// their rounding, so they are drawn as plain quads.
+int GetBrickSegments(const BrickStore &bricks) {
+  return (bricks.cellHeight >= ROUNDED_BRICK_HEIGHT) ? BRICK_SEGMENTS : 0;
+}
 
-  DrawText("Use UP/DOWN, ENTER to start",
-           SCREEN_WIDTH / 2 -
-               MeasureText("Use UP/DOWN, ENTER to start", 20) / 2,
-           SCREEN_HEIGHT / 2 + 120, 20, GRAY);
+// Grow the wall buffers to at least vertexCount vertices. Their contents are
+// rebuilt afterwards, so nothing is copied over.
+void ReserveWallMesh(int vertexCount) {
+  if (vertexCount <= wallMeshCapacity)
+    return;
+  if (wallMesh.vboId != nullptr)
+    UnloadMesh(wallMesh);
+  wallMesh = {0};
+  wallMesh.vertexCount = vertexCount;
+  wallMesh.triangleCount = vertexCount / 3;
+  wallMesh.vertices =
+      static_cast<float *>(MemAlloc(vertexCount * 3 * sizeof(float)));
+  wallMesh.texcoords =
+      static_cast<float *>(MemAlloc(vertexCount * 2 * sizeof(float)));
+  wallMesh.colors = static_cast<unsigned char *>(
+      MemAlloc(vertexCount * 4 * sizeof(unsigned char)));
+  UploadMesh(&wallMesh, true);
+  wallMeshCapacity = vertexCount;
 }
 
-void DrawGame() {
-  BeginDrawing();
+// Refill the wall mesh with every active static brick. Moving bricks change
+// each tick and are drawn directly instead.
+void RebuildWallMesh(const BrickStore &bricks) {
+  const int segments = GetBrickSegments(bricks);
+  ReserveWallMesh(bricks.count * RoundedRectVertexCount(segments));
+  int vertex = 0;
+  for (int brick = NextActiveBrick(bricks, 0); brick >= 0;
+       brick = NextActiveBrick(bricks, brick + 1)) {
+    if (bricks.moveSpeed[brick] == 0.0f) {
+      vertex = AppendRoundedRect(wallMesh, vertex, GetBrickRect(bricks, brick),
+                                 BRICK_ROUNDNESS, segments,
+                                 bricks.color[brick]);
+    }
+  }
+  UpdateMeshBuffer(wallMesh, 0, wallMesh.vertices, vertex * 3 * sizeof(float),
+                   0);
+  UpdateMeshBuffer(wallMesh, 3, wallMesh.colors,
+                   vertex * 4 * sizeof(unsigned char), 0);
+  wallMesh.vertexCount = vertex;
+  wallMesh.triangleCount = vertex / 3;
+  wallDirty = false;
+}
+
+void RenderStaticLayer(const BrickStore &bricks) {
+  PROFILE_SCOPE(PROFILE_DRAW_STATIC_LAYER);
+  BeginTextureMode(staticLayer);
   ClearBackground(MATTE_BLACK);
+  BeginMode2D(sceneCamera);
+  DrawBackground();
+  DrawStaticBricks(bricks);
+  EndMode2D();
+  CountProfileEvent(PROFILE_DRAW_CALLS); // Batch flushed into the layer
+  EndTextureMode();
+  wallDirty = false;
+}
 
-  if (backgroundTexture.id > 0) {
-    DrawTexturePro(backgroundTexture,
-                   {0.0f, 0.0f, (float)backgroundTexture.width,
-                    (float)backgroundTexture.height},
+void DrawBackground() {
+  const Texture2D &texture = backgroundAsset.texture;
+  if (texture.id > 0) {
+    DrawTexturePro(texture,
+                   {0.0f, 0.0f, (float)texture.width, (float)texture.height},
                    {0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT},
                    {0.0f, 0.0f}, 0.0f, WHITE);
   }
+}
 
-  switch (currentState) {
-  case GameState::MENU:
-    DrawMenu();
-    break;
+// Bricks that never move, with their hit-count labels
+void DrawStaticBricks(const BrickStore &bricks) {
+  if (wallMesh.vboId != nullptr) {
+    if (wallDirty)
+      RebuildWallMesh(bricks);
+    if (wallMesh.vertexCount > 0) {
+      rlDrawRenderBatchActive(); // Keep draw order with batched shapes
+      rlDisableBackfaceCulling();
+      DrawMesh(wallMesh, shapeMaterial, MatrixIdentity());
+      CountProfileEvent(PROFILE_DRAW_CALLS, 2);
+      rlEnableBackfaceCulling();
+    }
+  }
 
-  case GameState::PLAYING:
-  case GameState::GAME_OVER:
-  case GameState::YOU_WIN: {
-    DrawRectangleRounded(paddle.rect, 0.8f, 16, paddle.color);
-
-    for (int i = 0; i < BRICK_ROWS; i++) {
-      for (int j = 0; j < BRICKS_PER_ROW; j++) {
-        if (bricks[i][j].active) {
-          DrawRectangleRounded(bricks[i][j].rect, 0.2f, 8, bricks[i][j].color);
-          if (bricks[i][j].hitsRequired > 1) {
-            DrawText(TextFormat("%i", bricks[i][j].hitsRequired),
-                     bricks[i][j].rect.x + bricks[i][j].rect.width / 2 - 5,
-                     bricks[i][j].rect.y + 5, 20, WHITE);
-          }
-        }
-      }
+  const int segments = GetBrickSegments(bricks);
+  const bool labels = bricks.cellHeight >= LABELED_BRICK_HEIGHT;
+  for (int brick = NextActiveBrick(bricks, 0); brick >= 0;
+       brick = NextActiveBrick(bricks, brick + 1)) {
+    if (bricks.moveSpeed[brick] != 0.0f)
+      continue;
+    const Rectangle brickRect = GetBrickRect(bricks, brick);
+    if (wallMesh.vboId == nullptr && segments == 0) {
+      DrawRectangleRec(brickRect, bricks.color[brick]);
+    } else if (wallMesh.vboId == nullptr) {
+      DrawRectangleRounded(brickRect, BRICK_ROUNDNESS, segments,
+                           bricks.color[brick]);
     }
+    if (labels)
+      DrawHitLabel(brickRect, bricks.hitsRequired[brick]);
+  }
+}
 
-    for (const auto &powerUp : powerUps) {
-      if (powerUp.active) {
-        DrawRectangleRec(powerUp.rect, powerUp.color);
-        const char *label = nullptr;
-        switch (powerUp.type) {
-        case PowerUpType::PADDLE_SIZE_UP:
-          label = "P";
-          break;
-        case PowerUpType::BALL_SPEED_UP:
-          label = "S";
-          break;
-        case PowerUpType::EXTRA_LIFE:
-          label = "L";
-          break;
-        case PowerUpType::MULTI_BALL:
-          label = "M";
-          break;
-        default:
-          break;
-        }
-        if (label)
-          DrawText(label, powerUp.rect.x + 5, powerUp.rect.y + 5, 10, WHITE);
-      }
+void DrawMovingBricks(const BrickStore &bricks, float alpha) {
+  const int segments = GetBrickSegments(bricks);
+  const bool labels = bricks.cellHeight >= LABELED_BRICK_HEIGHT;
+  for (int brick = NextActiveBrick(bricks, 0); brick >= 0;
+       brick = NextActiveBrick(bricks, brick + 1)) {
+    if (bricks.moveSpeed[brick] == 0.0f)
+      continue;
+    Rectangle brickRect = GetBrickRect(bricks, brick);
+    brickRect.x = Interpolate(bricks.prevX[brick], brickRect.x, alpha);
+    if (segments == 0) {
+      DrawRectangleRec(brickRect, bricks.color[brick]);
+    } else {
+      DrawRectangleRounded(brickRect, BRICK_ROUNDNESS, segments,
+                           bricks.color[brick]);
     }
+    if (labels)
+      DrawHitLabel(brickRect, bricks.hitsRequired[brick]);
+  }
+}
+
+// Late latch: the newest tick published while the frame's background was
+// drawn replaces frame for the paddle and everything drawn over it, so input
+// reaches the screen sooner and the balls stay in step with the paddle.
+// Latest() hands the slot frame lives in back to the simulation, nothing may
+// read it after this. alpha is updated for the returned snapshot.
+const FrameSnapshot &LatchFrame(const FrameSnapshot &frame, float &alpha) {
+  if (spectateSocket.handle >= 0)
+    return frame;
+  const FrameSnapshot &latest = snapshots.Latest();
+  const double elapsed = GetClockTime() - latest.tickTime;
+  latchedInputTime = latest.inputTime;
+  alpha = static_cast<float>(std::min(elapsed / SIM_DT, 1.0));
+  return latest;
+}
+
+// Once a frame showing a new input is presented, time it from the poll that
+// read the input. Display scanout comes on top.
+void MeasureInputLatency() {
+  if (latchedInputTime <= shownInputTime)
+    return;
+  shownInputTime = latchedInputTime;
+  if (profilerEnabled.load(std::memory_order_relaxed)) {
+    const double now = GetProfileTime();
+    RecordProfileSample(PROFILE_INPUT_LATENCY,
+                        now - (inputPollTime - latchedInputTime), now);
+  }
+}
 
-    for (const auto &ball : balls) {
-      if (ball.active) {
-        for (size_t i = 0; i < ball.trail.size(); ++i) {
-          float alpha = 0.5f * (1.0f - (float)i / (ball.maxTrailLength * 3.0f));
-          Color trailColor = {ball.color.r, ball.color.g, ball.color.b,
-                              (unsigned char)(alpha * 255)};
-          float trailRadius =
-              ball.radius * (1.0f - (float)i / ball.maxTrailLength * 0.3f);
-          DrawCircleV(ball.trail[i], trailRadius, trailColor);
-        }
-        DrawCircleV(ball.position, ball.radius, ball.color);
+// The paddle mesh is rebuilt only when the paddle width changes and is
+// positioned with a translation at draw time
+void DrawPaddle(const Paddle &paddle, float alpha) {
+  PROFILE_SCOPE(PROFILE_DRAW_PADDLE);
+  const float x = Interpolate(paddle.prevX, paddle.rect.x, alpha);
+  if (paddleMesh.vboId == nullptr) {
+    DrawRectangleRounded({x, paddle.rect.y, paddle.rect.width,
+                          paddle.rect.height},
+                         PADDLE_ROUNDNESS, PADDLE_SEGMENTS, paddle.color);
+    return;
+  }
+
+  if (paddleMeshWidth != paddle.rect.width) {
+    AppendRoundedRect(paddleMesh, 0,
+                      {0.0f, 0.0f, paddle.rect.width, paddle.rect.height},
+                      PADDLE_ROUNDNESS, PADDLE_SEGMENTS, paddle.color);
+    UpdateMeshBuffer(paddleMesh, 0, paddleMesh.vertices,
+                     paddleMesh.vertexCount * 3 * sizeof(float), 0);
+    UpdateMeshBuffer(paddleMesh, 3, paddleMesh.colors,
+                     paddleMesh.vertexCount * 4 * sizeof(unsigned char), 0);
+    paddleMeshWidth = paddle.rect.width;
+  }
+  rlDrawRenderBatchActive();
+  rlDisableBackfaceCulling();
+  DrawMesh(paddleMesh, shapeMaterial, MatrixTranslate(x, paddle.rect.y, 0.0f));
+  CountProfileEvent(PROFILE_DRAW_CALLS, 2);
+  rlEnableBackfaceCulling();
+}
+
+// Trails of every ball as one triangle list, submitted in a single batch
+void DrawBallTrails(const GameSnapshot &game) {
+  int points = 0;
+  for (const auto &ball : game.balls)
+    points += ball.active ? ball.trail.count : 0;
+  if (points == 0)
+    return;
+
+  rlCheckRenderBatchLimit(points * TRAIL_SEGMENTS * 3);
+  rlBegin(RL_TRIANGLES);
+  const float step = 2.0f * PI / TRAIL_SEGMENTS;
+  for (const auto &ball : game.balls) {
+    if (!ball.active)
+      continue;
+    for (int i = 0; i < ball.trail.count; i++) {
+      const float fade = 0.5f * (1.0f - (float)i / (TRAIL_LENGTH * 3.0f));
+      const float radius =
+          ball.radius * (1.0f - (float)i / TRAIL_LENGTH * 0.3f);
+      const Vector2 center = GetTrailPoint(ball.trail, i);
+      rlColor4ub(ball.color.r, ball.color.g, ball.color.b,
+                 (unsigned char)(fade * 255));
+      for (int k = 0; k < TRAIL_SEGMENTS; k++) {
+        const float angle = k * step;
+        rlVertex2f(center.x, center.y);
+        rlVertex2f(center.x + std::cos(angle + step) * radius,
+                   center.y + std::sin(angle + step) * radius);
+        rlVertex2f(center.x + std::cos(angle) * radius,
+                   center.y + std::sin(angle) * radius);
       }
     }
+  }
+  rlEnd();
+}
 
-    DrawText(TextFormat("SCORE: %04i", score), 10, 10, 20, WHITE);
-    DrawText(TextFormat("LIVES: %i", lives), SCREEN_WIDTH - 100, 10, 20, WHITE);
-    const int minutes = static_cast<int>(countdownTimer / 60);
-    const int seconds = static_cast<int>(countdownTimer) % 60;
-    DrawText(TextFormat("TIME: %02i:%02i", minutes, seconds),
-             SCREEN_WIDTH / 2 - 50, 10, 20,
-             countdownTimer <= 10.0f ? RED : WHITE);
-    const char *diffText = (currentDifficulty == Difficulty::EASY) ? "EASY"
-                           : (currentDifficulty == Difficulty::MEDIUM)
-                               ? "MEDIUM"
-                               : "HARD";
-    DrawText(TextFormat("LEVEL: %i (%s)", currentLevel, diffText), 10, 40, 20,
-             WHITE);
-    DrawText("Press [B] for MENU", 10, SCREEN_HEIGHT - 30, 20, GRAY);
-
-    if (paused && currentState == GameState::PLAYING) {
-      DrawText("PAUSED", SCREEN_WIDTH / 2 - MeasureText("PAUSED", 40) / 2,
-               SCREEN_HEIGHT / 2 - 20, 40, GRAY);
+// Age the particles and draw them over the bricks
+void DrawParticles(const FrameSnapshot &frame) {
+  PROFILE_SCOPE(PROFILE_DRAW_PARTICLES);
+  if (!frame.paused)
+    UpdateParticles(particles, GetFrameTime());
+  CountProfileEvent(PROFILE_PARTICLES, particles.count);
+  if (particles.count == 0)
+    return;
+
+  if (particleMesh.vboId == nullptr) {
+    for (int i = 0; i < particles.count; i++) {
+      const float size = particles.size[i];
+      const float alpha = GetParticleAlpha(particles, i);
+      DrawRectangleRec({particles.x[i] - size / 2, particles.y[i] - size / 2,
+                        size, size},
+                       Fade(particles.color[i], alpha));
     }
-    break;
+    return;
   }
+
+  int vertex = 0;
+  auto emit = [&](float x, float y, Color color) {
+    particleMesh.vertices[vertex * 3 + 0] = x;
+    particleMesh.vertices[vertex * 3 + 1] = y;
+    particleMesh.vertices[vertex * 3 + 2] = 0.0f;
+    particleMesh.colors[vertex * 4 + 0] = color.r;
+    particleMesh.colors[vertex * 4 + 1] = color.g;
+    particleMesh.colors[vertex * 4 + 2] = color.b;
+    particleMesh.colors[vertex * 4 + 3] = color.a;
+    vertex++;
+  };
+  for (int i = 0; i < particles.count; i++) {
+    const float half = particles.size[i] / 2;
+    const float left = particles.x[i] - half;
+    const float top = particles.y[i] - half;
+    const float right = particles.x[i] + half;
+    const float bottom = particles.y[i] + half;
+    Color color = particles.color[i];
+    color.a = static_cast<unsigned char>(color.a *
+                                         GetParticleAlpha(particles, i));
+    emit(left, top, color);
+    emit(left, bottom, color);
+    emit(right, bottom, color);
+    emit(left, top, color);
+    emit(right, bottom, color);
+    emit(right, top, color);
   }
+  UpdateMeshBuffer(particleMesh, 0, particleMesh.vertices,
+                   vertex * 3 * sizeof(float), 0);
+  UpdateMeshBuffer(particleMesh, 3, particleMesh.colors,
+                   vertex * 4 * sizeof(unsigned char), 0);
+  particleMesh.vertexCount = vertex;
+  particleMesh.triangleCount = vertex / 3;
+  rlDrawRenderBatchActive(); // Keep draw order with batched shapes
+  rlDisableBackfaceCulling();
+  DrawMesh(particleMesh, shapeMaterial, MatrixIdentity());
+  CountProfileEvent(PROFILE_DRAW_CALLS, 2);
+  rlEnableBackfaceCulling();
+}
 
-  if (currentState == GameState::GAME_OVER) {
-    DrawRectangle(0, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH, 80,
-                  Fade(MATTE_BLACK, 0.7f));
-    DrawText("GAME OVER", SCREEN_WIDTH / 2 - MeasureText("GAME OVER", 40) / 2,
-             SCREEN_HEIGHT / 2 - 20, 40, RED);
-    DrawText("Press [ENTER] to MENU",
-             SCREEN_WIDTH / 2 - MeasureText("Press [ENTER] to MENU", 20) / 2,
-             SCREEN_HEIGHT / 2 + 25, 20, WHITE);
-  } else if (currentState == GameState::YOU_WIN) {
-    DrawRectangle(0, SCREEN_HEIGHT / 2 - 40, SCREEN_WIDTH, 80,
-                  Fade(MATTE_BLACK, 0.7f));
-    DrawText("YOU WIN!", SCREEN_WIDTH / 2 - MeasureText("YOU WIN!", 40) / 2,
-             SCREEN_HEIGHT / 2 - 20, 40, GREEN);
-    const char *nextText = (currentDifficulty != Difficulty::HARD)
-                               ? "Press [ENTER] for NEXT LEVEL"
-                               : "Press [ENTER] to MENU";
-    DrawText(nextText, SCREEN_WIDTH / 2 - MeasureText(nextText, 20) / 2,
-             SCREEN_HEIGHT / 2 + 25, 20, WHITE);
+// Sounds, debris for every brick that broke and sparks for every ball that
+// bounced off the paddle since the last frame. Sizes come from the frame
+// drawn, a brick index it no longer has belongs to a level already gone.
+void PlayGameEvents(const FrameSnapshot &frame) {
+  // By GameEventType, SOUND_EFFECT_COUNT for silent
+  static const SoundEffect sounds[] = {SOUND_BRICK_HIT,  SOUND_BRICK_DESTROYED,
+                                       SOUND_PADDLE_HIT, SOUND_EFFECT_COUNT,
+                                       SOUND_POWERUP,    SOUND_BALL_LOST};
+  const BrickStore &bricks = frame.game.bricks;
+  const float paddleTop = frame.game.paddle.rect.y;
+  bool played[SOUND_EFFECT_COUNT + 1] = {false}; // Once a frame, not louder
+  int events = 0;
+  GameEvent event;
+  while (gameEvents.Pop(event)) {
+    events++;
+    const SoundEffect sound = sounds[static_cast<int>(event.type)];
+    if (!played[sound] && sound != SOUND_EFFECT_COUNT)
+      PlaySoundEffect(sound);
+    played[sound] = true;
+    if (event.type == GameEventType::POWERUP_COLLECTED)
+      gamePowerUps++;
+
+    if (event.type == GameEventType::BRICK_DESTROYED &&
+        event.brick < bricks.count) {
+      const float width = bricks.width[event.brick];
+      const float height = bricks.height[event.brick];
+      // A brick always breaks on its last hit, so in that hit's color
+      EmitParticles(particles, {{event.position.x - width / 2,
+                                 event.position.y - height / 2, width, height},
+                                {0.0f, -120.0f}, 220.0f, 0.8f, 4.0f,
+                                GetBrickColor(1), DEBRIS_PER_BRICK});
+    } else if (event.type == GameEventType::PADDLE_HIT) {
+      EmitParticles(particles, {{event.position.x, paddleTop, 0.0f, 0.0f},
+                                {0.0f, -150.0f}, 250.0f, 0.35f, 3.0f, WHITE,
+                                SPARKS_PER_BOUNCE});
+    }
   }
+  CountProfileEvent(PROFILE_GAME_EVENTS, events);
+}
 
-  EndDrawing();
+// Drop what an earlier game left queued. The simulation thread is stopped.
+void ClearGameEvents() {
+  GameEvent event;
+  while (gameEvents.Pop(event)) {
+  }
+  const unsigned int dropped = gameEvents.dropped.exchange(0);
+  if (dropped > 0)
+    TraceLog(LOG_WARNING, "Failed to queue %u game events.", dropped);
 }
 
 void UnloadGame() {
-  powerUps.clear();
-  balls.clear();
-  if (backgroundTexture.id > 0) {
-    UnloadTexture(backgroundTexture);
-    backgroundTexture = {0};
-  }
+  StopSimulation();
+  FinishRecording();
+  RecordGame();
+  CloseRecordStore();
+  CloseUdp(broadcastSocket);
+  CloseUdp(spectateSocket);
+  UnloadRenderCache();
+  UnloadRenderTargets();
+  UnloadAssets(&backgroundAsset, 1);
+  CloseLevelPack(levelPack);
+  CloseGameAudio();
 }
 
 void UpdateDrawFrame() {
-  UpdateGame();
-  DrawGame();
+  // The static layer holds the background, repaint it once that is uploaded
+  if (UpdateAssets(&backgroundAsset, 1))
+    wallDirty = true;
+  if (IsWindowResized())
+    LoadRenderTargets();
+  UpdateRenderScale();
+  UpdateProfiler();
+  {
+    PROFILE_SCOPE(PROFILE_FRAME);
+    if (spectateSocket.handle >= 0) {
+      {
+        PROFILE_SCOPE(PROFILE_UPDATE);
+        UpdateSpectator();
+      }
+      if (currentState == GameState::MENU) {
+        DrawSpectatorWaiting();
+      } else {
+        const double elapsed = GetClockTime() - spectatorFrame.tickTime;
+        DrawGame(spectatorFrame,
+                 static_cast<float>(std::min(elapsed / SIM_DT, 1.0)));
+      }
+    } else {
+      {
+        PROFILE_SCOPE(PROFILE_UPDATE);
+        UpdateGame();
+      }
+
+      // Interpolate from the newest published tick by the time since it ended
+      const FrameSnapshot &frame = snapshots.Latest();
+      const double elapsed = GetClockTime() - frame.tickTime;
+      DrawGame(frame, static_cast<float>(std::min(elapsed / SIM_DT, 1.0)));
+    }
+  }
+  // EndDrawing() presented the frame, then polled the devices
+  inputPollTime = GetClockTime();
+  if (currentState == GameState::PLAYING && !paused && recordingGame)
+    AddFrameTime(gameFrameTimes, GetFrameTime());
+  MeasureInputLatency();
+  UpdateStressTest();
+  EndProfileFrame();
 }
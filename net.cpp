@@ -0,0 +1,471 @@
+#include "net.h"
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr uint32_t NET_STALE_WINDOW = 1024; // Older packets are reordered ones
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Bounds-checked cursor over a received packet
+struct NetReader {
+  const uint8_t *data;
+  size_t size;
+  size_t offset;
+  bool valid; // Cleared by the first read past the end
+};
+
+struct NetPoint {
+  float x;
+  float y;
+};
+
+struct NetPowerUp {
+  PowerUpType type;
+  NetPoint position;
+};
+
+struct NetBrick {
+  int index;
+  int hits; // With NET_MOVING in keyframes
+};
+
+struct NetMovingBrick {
+  int index;
+  float x;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void Put8(NetPacket &packet, uint32_t value);
+static void Put16(NetPacket &packet, uint32_t value);
+static void Put32(NetPacket &packet, uint32_t value);
+static void PutVarint(NetPacket &packet, uint32_t value);
+static void PutPosition(NetPacket &packet, float value);
+static uint32_t Get8(NetReader &reader);
+static uint32_t Get16(NetReader &reader);
+static uint32_t Get32(NetReader &reader);
+static uint32_t GetVarint(NetReader &reader);
+static float GetPosition(NetReader &reader);
+static bool NeedsKeyframe(const NetEncoder &encoder, const GameWorld &world);
+static void ApplyBricks(NetDecoder &decoder, bool keyframe, int rows,
+                        int cols, const NetBrick *changes, int changeCount,
+                        const NetMovingBrick *moving, int movingCount);
+static void PushBrickDestroyed(NetDecoder &decoder, int brick);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+bool EncodeNetPacket(NetEncoder &encoder, const GameSession &session,
+                     NetPacket &packet) {
+  const GameWorld &world = session.world;
+  const BrickStore &bricks = world.bricks;
+  packet.size = 0;
+  packet.overflow = false;
+  if (bricks.count > NET_MAX_BRICKS)
+    return false;
+
+  const bool keyframe = NeedsKeyframe(encoder, world);
+  if (keyframe) {
+    encoder.keyframeId++;
+    encoder.ticksSinceKeyframe = 0;
+    encoder.hasKeyframe = true;
+    encoder.keyframeDifficulty = world.difficulty;
+    encoder.keyframe.rows = bricks.rows;
+    encoder.keyframe.cols = bricks.cols;
+    for (int brick = 0; brick < bricks.count; brick++) {
+      const bool active = IsBrickActive(bricks, brick);
+      encoder.keyframe.hits[brick] =
+          active ? static_cast<uint8_t>(bricks.hitsRequired[brick]) : 0;
+      encoder.keyframe.moving[brick] =
+          active && bricks.moveSpeed[brick] != 0.0f;
+    }
+  }
+  encoder.ticksSinceKeyframe++;
+
+  Put8(packet, NET_VERSION);
+  Put8(packet, keyframe ? NET_KEYFRAME : NET_DELTA);
+  Put32(packet, ++encoder.sequence);
+  Put16(packet, encoder.keyframeId);
+  Put32(packet, world.tickCount);
+
+  Put8(packet, static_cast<uint32_t>(session.state));
+  Put8(packet, (session.paused ? NET_PAUSED : 0) |
+                   (HasNextLevel(world) ? NET_NEXT_LEVEL : 0));
+  PutVarint(packet, static_cast<uint32_t>(GetSessionLevel(session)));
+  Put8(packet, static_cast<uint32_t>(world.difficulty));
+  Put8(packet, static_cast<uint32_t>(world.status));
+  PutVarint(packet, std::max(world.score, 0));
+  Put8(packet,
+       static_cast<uint8_t>(std::max(-128, std::min(world.lives, 127))));
+  Put16(packet, static_cast<uint32_t>(
+                    std::max(0.0f, std::ceil(world.countdownTimer * 10.0f))));
+  PutPosition(packet, world.paddle.rect.x);
+  PutPosition(packet, world.paddle.rect.y);
+  PutPosition(packet, world.paddle.rect.width);
+
+  PutVarint(packet, world.balls.size());
+  for (const auto &ball : world.balls) {
+    PutPosition(packet, ball.position.x);
+    PutPosition(packet, ball.position.y);
+  }
+  PutVarint(packet, world.powerUps.size());
+  for (const auto &powerUp : world.powerUps) {
+    Put8(packet, static_cast<uint32_t>(powerUp.type));
+    PutPosition(packet, powerUp.rect.x);
+    PutPosition(packet, powerUp.rect.y);
+  }
+
+  // Brick section: the whole wall, or only what hits changed since then
+  if (keyframe) {
+    Put8(packet, bricks.rows);
+    Put8(packet, bricks.cols);
+  }
+  const size_t countOffset = packet.size;
+  int count = 0;
+  Put8(packet, 0);
+  for (int brick = 0; brick < bricks.count; brick++) {
+    const int hits =
+        IsBrickActive(bricks, brick) ? bricks.hitsRequired[brick] : 0;
+    if (keyframe && hits > 0) {
+      Put8(packet, brick);
+      Put8(packet, hits | (encoder.keyframe.moving[brick] ? NET_MOVING : 0));
+      count++;
+    } else if (!keyframe && hits != encoder.keyframe.hits[brick]) {
+      Put8(packet, brick);
+      Put8(packet, hits);
+      count++;
+    }
+  }
+  if (countOffset < NET_MAX_PACKET)
+    packet.data[countOffset] = static_cast<uint8_t>(count);
+
+  count = 0;
+  for (const int brick : world.movingBricks)
+    count += IsBrickActive(bricks, brick);
+  Put8(packet, count);
+  for (const int brick : world.movingBricks) {
+    if (!IsBrickActive(bricks, brick))
+      continue;
+    Put8(packet, brick);
+    PutPosition(packet, bricks.x[brick]);
+  }
+
+  // Spectators drop deltas against a keyframe they never got, so one that
+  // did not fit is tried again on the next tick
+  if (packet.overflow && keyframe)
+    encoder.ticksSinceKeyframe = NET_KEYFRAME_TICKS;
+  return !packet.overflow;
+}
+
+bool ApplyNetPacket(NetDecoder &decoder, const uint8_t *data, size_t size) {
+  NetReader reader = {data, size, 0, true};
+  if (Get8(reader) != NET_VERSION)
+    return false;
+  const uint32_t kind = Get8(reader);
+  const uint32_t sequence = Get32(reader);
+  const uint32_t keyframeId = Get16(reader);
+  const uint32_t tick = Get32(reader);
+  const bool keyframe = kind == NET_KEYFRAME;
+  if (!reader.valid || (!keyframe && kind != NET_DELTA))
+    return false;
+  if (decoder.sequence - sequence < NET_STALE_WINDOW && decoder.hasKeyframe)
+    return false;
+  if (!keyframe && (!decoder.hasKeyframe || keyframeId != decoder.keyframeId))
+    return false;
+
+  const uint32_t state = Get8(reader);
+  const uint32_t flags = Get8(reader);
+  const int level = static_cast<int>(GetVarint(reader));
+  const uint32_t difficulty = Get8(reader);
+  const uint32_t status = Get8(reader);
+  const int score = static_cast<int>(GetVarint(reader));
+  const int lives = static_cast<int8_t>(Get8(reader));
+  const float timer = Get16(reader) / 10.0f;
+  Rectangle paddle = {0};
+  paddle.x = GetPosition(reader);
+  paddle.y = GetPosition(reader);
+  paddle.width = GetPosition(reader);
+  paddle.height = PADDLE_HEIGHT;
+
+  NetPoint balls[BALL_POOL_SIZE];
+  const int ballCount = static_cast<int>(
+      std::min(GetVarint(reader), static_cast<uint32_t>(BALL_POOL_SIZE + 1)));
+  for (int i = 0; i < ballCount && i < BALL_POOL_SIZE; i++)
+    balls[i] = {GetPosition(reader), GetPosition(reader)};
+  NetPowerUp powerUps[POWERUP_POOL_SIZE];
+  const int powerUpCount = static_cast<int>(std::min(
+      GetVarint(reader), static_cast<uint32_t>(POWERUP_POOL_SIZE + 1)));
+  for (int i = 0; i < powerUpCount && i < POWERUP_POOL_SIZE; i++) {
+    powerUps[i].type = static_cast<PowerUpType>(Get8(reader));
+    powerUps[i].position = {GetPosition(reader), GetPosition(reader)};
+  }
+
+  // Deltas use the grid of the keyframe they refer to
+  const int rows = keyframe ? Get8(reader) : decoder.keyframe.rows;
+  const int cols = keyframe ? Get8(reader) : decoder.keyframe.cols;
+  const int bricks = rows * cols;
+  NetBrick changes[NET_MAX_BRICKS];
+  const int changeCount = Get8(reader);
+  for (int i = 0; i < changeCount && i < bricks; i++) {
+    changes[i].index = Get8(reader);
+    changes[i].hits = Get8(reader);
+    reader.valid &= changes[i].index < bricks;
+  }
+  NetMovingBrick moving[NET_MAX_BRICKS];
+  const int movingCount = Get8(reader);
+  for (int i = 0; i < movingCount && i < bricks; i++) {
+    moving[i].index = Get8(reader);
+    moving[i].x = GetPosition(reader);
+    reader.valid &= moving[i].index < bricks;
+  }
+
+  if (!reader.valid || rows == 0 || cols == 0 || bricks > NET_MAX_BRICKS ||
+      ballCount > BALL_POOL_SIZE || powerUpCount > POWERUP_POOL_SIZE ||
+      changeCount > bricks || movingCount > bricks ||
+      state > (uint32_t)GameState::YOU_WIN ||
+      difficulty >= (uint32_t)DIFFICULTY_COUNT ||
+      status > (uint32_t)LevelStatus::CLEARED)
+    return false;
+
+  // Everything parsed: move the rebuilt game forward one received tick
+  GameSnapshot &game = decoder.game;
+  const bool sampleTrail = tick != game.tickCount &&
+                           tick % TRAIL_SAMPLE_TICKS == 0;
+  const bool newLevel = level != decoder.level || tick < game.tickCount;
+  const int firstEvent = decoder.events.size();
+  decoder.sequence = sequence;
+  decoder.state = static_cast<GameState>(state);
+  decoder.paused = (flags & NET_PAUSED) != 0;
+  decoder.level = level;
+  game.difficulty = static_cast<Difficulty>(difficulty);
+  game.status = static_cast<LevelStatus>(status);
+  game.hasNextLevel = (flags & NET_NEXT_LEVEL) != 0;
+  game.score = score;
+  game.lives = lives;
+  game.countdownTimer = timer;
+  game.tickCount = tick;
+
+  game.paddle.prevX = decoder.hasKeyframe ? game.paddle.rect.x : paddle.x;
+  game.paddle.rect = paddle;
+  game.paddle.color = LIGHTGRAY;
+
+  const int previousBalls = game.balls.size();
+  while (game.balls.size() > ballCount)
+    game.balls.remove(game.balls.size() - 1);
+  while (game.balls.size() < ballCount)
+    game.balls.push_back(Ball{0});
+  for (int i = 0; i < ballCount; i++) {
+    Ball &ball = game.balls[i];
+    const Vector2 position = {balls[i].x, balls[i].y};
+    if (i < previousBalls && decoder.hasKeyframe) {
+      if (sampleTrail)
+        PushTrailPoint(ball.trail, ball.position);
+      ball.prevPosition = ball.position;
+    } else {
+      ball = Ball{0};
+      ball.prevPosition = position;
+      ball.radius = BALL_RADIUS;
+      ball.color = WHITE;
+      ball.active = true;
+    }
+    ball.position = position;
+  }
+
+  const int previousPowerUps = game.powerUps.size();
+  while (game.powerUps.size() > powerUpCount)
+    game.powerUps.remove(game.powerUps.size() - 1);
+  while (game.powerUps.size() < powerUpCount)
+    game.powerUps.push_back(PowerUp{});
+  for (int i = 0; i < powerUpCount; i++) {
+    PowerUp &powerUp = game.powerUps[i];
+    const bool known = i < previousPowerUps && decoder.hasKeyframe &&
+                       powerUp.type == powerUps[i].type;
+    powerUp.prevY = known ? powerUp.rect.y : powerUps[i].position.y;
+    powerUp.rect = {powerUps[i].position.x, powerUps[i].position.y,
+                    POWERUP_SIZE, POWERUP_SIZE};
+    powerUp.type = powerUps[i].type;
+    powerUp.active = true;
+    powerUp.color = GetPowerUpColor(powerUp.type);
+  }
+
+  ApplyBricks(decoder, keyframe, rows, cols, changes, changeCount, moving,
+              movingCount);
+  // Cells a new level leaves empty did not break
+  while (newLevel && decoder.events.size() > firstEvent)
+    decoder.events.remove(decoder.events.size() - 1);
+  if (keyframe) {
+    decoder.keyframeId = static_cast<uint16_t>(keyframeId);
+    decoder.hasKeyframe = true;
+  }
+  return true;
+}
+
+// A keyframe goes out on a timer, and whenever a brick appears or regains
+// hits, which only a new level or a new game does
+bool NeedsKeyframe(const NetEncoder &encoder, const GameWorld &world) {
+  if (!encoder.hasKeyframe ||
+      encoder.ticksSinceKeyframe >= NET_KEYFRAME_TICKS ||
+      encoder.keyframeDifficulty != world.difficulty ||
+      encoder.keyframe.rows != world.bricks.rows ||
+      encoder.keyframe.cols != world.bricks.cols)
+    return true;
+  for (int brick = NextActiveBrick(world.bricks, 0); brick >= 0;
+       brick = NextActiveBrick(world.bricks, brick + 1)) {
+    if (world.bricks.hitsRequired[brick] > encoder.keyframe.hits[brick])
+      return true;
+  }
+  return false;
+}
+
+// Rebuild the brick store from the keyframe plus the changes since then.
+// The static layer is only invalidated when a static brick changed.
+void ApplyBricks(NetDecoder &decoder, bool keyframe, int rows, int cols,
+                 const NetBrick *changes, int changeCount,
+                 const NetMovingBrick *moving, int movingCount) {
+  BrickStore &bricks = decoder.game.bricks;
+  const bool resized = rows != bricks.rows || cols != bricks.cols;
+  uint8_t oldHits[NET_MAX_BRICKS] = {0};
+  bool oldMoving[NET_MAX_BRICKS] = {false};
+  float oldX[NET_MAX_BRICKS] = {0.0f};
+  for (int brick = 0; brick < bricks.count && !resized; brick++) {
+    const bool active = decoder.hasKeyframe && IsBrickActive(bricks, brick);
+    oldHits[brick] = active ? bricks.hitsRequired[brick] : 0;
+    oldMoving[brick] = active && bricks.moveSpeed[brick] != 0.0f;
+    oldX[brick] = bricks.x[brick];
+  }
+
+  // A keyframe also puts every brick back in its grid cell
+  if (keyframe) {
+    InitBrickGrid(bricks, rows, cols);
+    decoder.keyframe.rows = rows;
+    decoder.keyframe.cols = cols;
+    for (int brick = 0; brick < NET_MAX_BRICKS; brick++) {
+      decoder.keyframe.hits[brick] = 0;
+      decoder.keyframe.moving[brick] = false;
+    }
+    for (int i = 0; i < changeCount; i++) {
+      decoder.keyframe.hits[changes[i].index] = changes[i].hits & ~NET_MOVING;
+      decoder.keyframe.moving[changes[i].index] =
+          (changes[i].hits & NET_MOVING) != 0;
+    }
+  }
+
+  uint8_t hits[NET_MAX_BRICKS];
+  std::copy(decoder.keyframe.hits, decoder.keyframe.hits + NET_MAX_BRICKS,
+            hits);
+  if (!keyframe) {
+    for (int i = 0; i < changeCount; i++)
+      hits[changes[i].index] = static_cast<uint8_t>(changes[i].hits);
+  }
+
+  bool staticChanged = resized;
+  for (int brick = 0; brick < bricks.count; brick++) {
+    const bool isMoving = hits[brick] > 0 && decoder.keyframe.moving[brick];
+    const bool wasStatic = oldHits[brick] > 0 && !oldMoving[brick];
+    const bool isStatic = hits[brick] > 0 && !isMoving;
+    if ((wasStatic || isStatic) &&
+        (hits[brick] != oldHits[brick] || isMoving != oldMoving[brick]))
+      staticChanged = true;
+
+    // Hit events are not streamed, a brick breaking shows in its hits
+    if (oldHits[brick] > 0 && hits[brick] == 0)
+      PushBrickDestroyed(decoder, brick);
+
+    SetBrickActive(bricks, brick, hits[brick] > 0);
+    bricks.hitsRequired[brick] = hits[brick];
+    bricks.color[brick] = GetBrickColor(hits[brick]);
+    bricks.moveSpeed[brick] = isMoving ? MOVING_BRICK_SPEED : 0.0f;
+    bricks.prevX[brick] = bricks.x[brick];
+  }
+
+  for (int i = 0; i < movingCount; i++) {
+    const int brick = moving[i].index;
+    bricks.prevX[brick] = oldMoving[brick] ? oldX[brick] : moving[i].x;
+    bricks.x[brick] = moving[i].x;
+  }
+  if (staticChanged || (keyframe && !decoder.hasKeyframe))
+    decoder.game.wallVersion++;
+}
+
+// Events of packets nobody took yet are kept until the pool is full
+void PushBrickDestroyed(NetDecoder &decoder, int brick) {
+  const BrickStore &bricks = decoder.game.bricks;
+  GameEvent event = {GameEventType::BRICK_DESTROYED};
+  event.brick = static_cast<uint16_t>(brick);
+  event.position = {bricks.x[brick] + bricks.width[brick] / 2,
+                    bricks.y[brick] + bricks.height[brick] / 2};
+  decoder.events.push_back(event);
+}
+
+void Put8(NetPacket &packet, uint32_t value) {
+  if (packet.size < NET_MAX_PACKET)
+    packet.data[packet.size++] = static_cast<uint8_t>(value);
+  else
+    packet.overflow = true;
+}
+
+void Put16(NetPacket &packet, uint32_t value) {
+  Put8(packet, value);
+  Put8(packet, value >> 8);
+}
+
+void Put32(NetPacket &packet, uint32_t value) {
+  Put16(packet, value);
+  Put16(packet, value >> 16);
+}
+
+// LEB128, as in replay files
+void PutVarint(NetPacket &packet, uint32_t value) {
+  while (value >= 0x80) {
+    Put8(packet, value | 0x80);
+    value >>= 7;
+  }
+  Put8(packet, value);
+}
+
+void PutPosition(NetPacket &packet, float value) {
+  const float scaled = std::round(value * NET_POSITION_SCALE);
+  Put16(packet, static_cast<uint16_t>(static_cast<int16_t>(
+                    std::max(-32768.0f, std::min(scaled, 32767.0f)))));
+}
+
+uint32_t Get8(NetReader &reader) {
+  if (reader.offset >= reader.size) {
+    reader.valid = false;
+    return 0;
+  }
+  return reader.data[reader.offset++];
+}
+
+uint32_t Get16(NetReader &reader) {
+  const uint32_t low = Get8(reader);
+  return low | Get8(reader) << 8;
+}
+
+uint32_t Get32(NetReader &reader) {
+  const uint32_t low = Get16(reader);
+  return low | Get16(reader) << 16;
+}
+
+uint32_t GetVarint(NetReader &reader) {
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    const uint32_t byte = Get8(reader);
+    value |= (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return value;
+  }
+  reader.valid = false;
+  return 0;
+}
+
+float GetPosition(NetReader &reader) {
+  return static_cast<int16_t>(Get16(reader)) / NET_POSITION_SCALE;
+}
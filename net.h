@@ -0,0 +1,97 @@
+#ifndef NET_H
+#define NET_H
+
+#include "game.h"
+#include "session.h"
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------
+// Spectator stream: one small datagram per tick that lets a remote client
+// rebuild a GameSnapshot and draw it locally.
+//
+// Packet layout (little endian):
+//   u8 version, u8 kind, u32 sequence, u16 keyframe id, u32 tick,
+//   u8 state, u8 flags (NET_PAUSED, NET_NEXT_LEVEL), varint level,
+//   u8 difficulty, u8 status, varint score,
+//   i8 lives, u16 timer (1/10 s), i16 paddle x, y and width,
+//   varint ball count, per ball: i16 x, i16 y,
+//   varint power-up count, per power-up: u8 type, i16 x, i16 y,
+//   keyframe: u8 rows, u8 cols,
+//             u8 count, per active brick: u8 index, u8 hits | NET_MOVING
+//   delta:    u8 count, per brick changed since the keyframe: u8 index, u8 hits
+//   then u8 count, per active moving brick: u8 index, i16 x
+// Positions are fixed point with NET_POSITION_SCALE steps per pixel. Walls of
+// more than NET_MAX_BRICKS cells, and ticks that do not fit in
+// NET_MAX_PACKET bytes, are not streamed.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr uint8_t NET_VERSION = 5;
+constexpr uint8_t NET_KEYFRAME = 1; // Carries the full brick layout
+constexpr uint8_t NET_DELTA = 2;    // Bricks relative to the last keyframe
+constexpr uint8_t NET_MOVING = 0x80; // Brick flag in keyframes
+constexpr uint8_t NET_PAUSED = 0x01; // Session flags
+constexpr uint8_t NET_NEXT_LEVEL = 0x02;
+constexpr float NET_POSITION_SCALE = 8.0f;
+constexpr int NET_KEYFRAME_TICKS = 60; // A lost keyframe costs at most 0.5 s
+constexpr int NET_MAX_PACKET = 1200;   // Fits any MTU on the way
+constexpr int NET_MAX_BRICKS = 255;    // Brick indices and counts are u8
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Brick hit counts as of a keyframe, 0 where no brick stands
+struct NetBrickState {
+  int rows;
+  int cols;
+  uint8_t hits[NET_MAX_BRICKS];
+  bool moving[NET_MAX_BRICKS];
+};
+
+struct NetPacket {
+  uint8_t data[NET_MAX_PACKET];
+  size_t size;
+  bool overflow; // Set by the first write past NET_MAX_PACKET
+};
+
+// Broadcaster side
+struct NetEncoder {
+  uint32_t sequence;
+  uint16_t keyframeId;
+  int ticksSinceKeyframe;
+  bool hasKeyframe;
+  Difficulty keyframeDifficulty;
+  NetBrickState keyframe;
+};
+
+// Spectator side: the rebuilt game, ready for the renderer
+struct NetDecoder {
+  uint32_t sequence; // Newest packet applied
+  uint16_t keyframeId;
+  bool hasKeyframe;
+  NetBrickState keyframe;
+  GameSnapshot game;
+  GameState state;
+  bool paused;
+  int level;
+  Pool<GameEvent, NET_MAX_BRICKS> events; // Bricks seen breaking, for the
+                                          // caller to take and clear
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Returns false, with nothing to send, while the wall is too large to stream
+// or the tick does not fit in one packet
+bool EncodeNetPacket(NetEncoder &encoder, const GameSession &session,
+                     NetPacket &packet);
+
+// Returns false for packets that are malformed, stale or refer to a keyframe
+// the decoder never received; the decoder is left unchanged then
+bool ApplyNetPacket(NetDecoder &decoder, const uint8_t *data, size_t size);
+
+#endif // NET_H
@@ -0,0 +1,129 @@
+#include "particles.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PARTICLES_USE_NEON
+#endif
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static float NextParticleRandom(ParticlePool &pool);
+static void IntegrateParticles(ParticlePool &pool, float dt);
+static void RemoveExpiredParticles(ParticlePool &pool);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void ResetParticles(ParticlePool &pool, uint32_t seed) {
+  pool.count = 0;
+  pool.dropped = 0;
+  pool.rng = (seed != 0) ? seed : 1; // xorshift never leaves 0
+}
+
+void EmitParticles(ParticlePool &pool, const ParticleBurst &burst) {
+  const int count = std::min(burst.count, PARTICLE_CAPACITY - pool.count);
+  pool.dropped += burst.count - count;
+  for (int n = 0; n < count; n++) {
+    const int i = pool.count++;
+    const float angle = NextParticleRandom(pool) * 2.0f * PI;
+    const float speed = NextParticleRandom(pool) * burst.spread;
+    const float lifetime =
+        burst.lifetime * (0.5f + 0.5f * NextParticleRandom(pool));
+    pool.x[i] = burst.area.x + NextParticleRandom(pool) * burst.area.width;
+    pool.y[i] = burst.area.y + NextParticleRandom(pool) * burst.area.height;
+    pool.vx[i] = burst.velocity.x + std::cos(angle) * speed;
+    pool.vy[i] = burst.velocity.y + std::sin(angle) * speed;
+    pool.life[i] = lifetime;
+    pool.fade[i] = 1.0f / lifetime;
+    pool.size[i] = burst.size;
+    pool.color[i] = burst.color;
+  }
+}
+
+void UpdateParticles(ParticlePool &pool, float dt) {
+  if (pool.count == 0)
+    return;
+  IntegrateParticles(pool, dt);
+  RemoveExpiredParticles(pool);
+}
+
+float GetParticleAlpha(const ParticlePool &pool, int particle) {
+  return std::min(pool.life[particle] * pool.fade[particle], 1.0f);
+}
+
+// Uniform in [0, 1)
+float NextParticleRandom(ParticlePool &pool) {
+  uint32_t v = pool.rng;
+  v ^= v << 13;
+  v ^= v >> 17;
+  v ^= v << 5;
+  pool.rng = v;
+  return (v >> 8) * (1.0f / 16777216.0f);
+}
+
+// Whole lanes up to the last live particle. The arrays are sized in lanes, so
+// the tail past count is updated harmlessly instead of branched around.
+void IntegrateParticles(ParticlePool &pool, float dt) {
+  const int end = (pool.count + PARTICLE_LANES - 1) / PARTICLE_LANES *
+                  PARTICLE_LANES;
+#if defined(PARTICLES_USE_SSE)
+  const __m128 step = _mm_set1_ps(dt);
+  const __m128 fall = _mm_set1_ps(PARTICLE_GRAVITY * dt);
+  for (int i = 0; i < end; i += PARTICLE_LANES) {
+    const __m128 vy = _mm_add_ps(_mm_load_ps(&pool.vy[i]), fall);
+    _mm_store_ps(&pool.x[i],
+                 _mm_add_ps(_mm_load_ps(&pool.x[i]),
+                            _mm_mul_ps(_mm_load_ps(&pool.vx[i]), step)));
+    _mm_store_ps(&pool.y[i],
+                 _mm_add_ps(_mm_load_ps(&pool.y[i]), _mm_mul_ps(vy, step)));
+    _mm_store_ps(&pool.vy[i], vy);
+    _mm_store_ps(&pool.life[i], _mm_sub_ps(_mm_load_ps(&pool.life[i]), step));
+  }
+#elif defined(PARTICLES_USE_NEON)
+  const float32x4_t step = vdupq_n_f32(dt);
+  const float32x4_t fall = vdupq_n_f32(PARTICLE_GRAVITY * dt);
+  for (int i = 0; i < end; i += PARTICLE_LANES) {
+    const float32x4_t vy = vaddq_f32(vld1q_f32(&pool.vy[i]), fall);
+    vst1q_f32(&pool.x[i],
+              vmlaq_f32(vld1q_f32(&pool.x[i]), vld1q_f32(&pool.vx[i]), step));
+    vst1q_f32(&pool.y[i], vmlaq_f32(vld1q_f32(&pool.y[i]), vy, step));
+    vst1q_f32(&pool.vy[i], vy);
+    vst1q_f32(&pool.life[i], vsubq_f32(vld1q_f32(&pool.life[i]), step));
+  }
+#else
+  for (int i = 0; i < end; i++) {
+    pool.vy[i] += PARTICLE_GRAVITY * dt;
+    pool.x[i] += pool.vx[i] * dt;
+    pool.y[i] += pool.vy[i] * dt;
+    pool.life[i] -= dt;
+  }
+#endif
+}
+
+// Move the last live particle into each expired slot, keeping the pool packed
+// without caring about order
+void RemoveExpiredParticles(ParticlePool &pool) {
+  int i = 0;
+  while (i < pool.count) {
+    if (pool.life[i] > 0.0f) {
+      i++;
+      continue;
+    }
+    const int last = --pool.count;
+    pool.x[i] = pool.x[last];
+    pool.y[i] = pool.y[last];
+    pool.vx[i] = pool.vx[last];
+    pool.vy[i] = pool.vy[last];
+    pool.life[i] = pool.life[last];
+    pool.fade[i] = pool.fade[last];
+    pool.size[i] = pool.size[last];
+    pool.color[i] = pool.color[last];
+  }
+}
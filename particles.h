@@ -0,0 +1,62 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "raylib.h"
+#include <cstdint>
+
+//----------------------------------------------------------------------------------
+// Debris and sparks. Purely visual, updated once per render frame on the main
+// thread. Particles live in a fixed structure-of-arrays pool, packed at the
+// front, so the update is one vectorized pass and memory never grows: bursts
+// past PARTICLE_CAPACITY are cut short and counted as dropped.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int PARTICLE_CAPACITY = 4096;    // Multiple of PARTICLE_LANES
+constexpr int PARTICLE_LANES = 4;          // Updated per SIMD instruction
+constexpr float PARTICLE_GRAVITY = 900.0f; // Pixels per second squared
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct ParticlePool {
+  int count;            // Live particles, indices 0 .. count - 1
+  unsigned int dropped; // Particles refused at the cap since the reset
+  uint32_t rng;         // Own xorshift stream, the game's stays untouched
+  alignas(16) float x[PARTICLE_CAPACITY];
+  alignas(16) float y[PARTICLE_CAPACITY];
+  alignas(16) float vx[PARTICLE_CAPACITY];
+  alignas(16) float vy[PARTICLE_CAPACITY];
+  alignas(16) float life[PARTICLE_CAPACITY];  // Seconds left
+  alignas(16) float fade[PARTICLE_CAPACITY];  // 1 / lifetime, for the alpha
+  alignas(16) float size[PARTICLE_CAPACITY];
+  Color color[PARTICLE_CAPACITY];
+};
+
+// count particles spread over area, moving at velocity plus up to spread in
+// a random direction
+struct ParticleBurst {
+  Rectangle area;
+  Vector2 velocity;
+  float spread;
+  float lifetime; // Seconds, each particle gets 50% to 100% of it
+  float size;
+  Color color;
+  int count;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void ResetParticles(ParticlePool &pool, uint32_t seed);
+void EmitParticles(ParticlePool &pool, const ParticleBurst &burst);
+
+// Move every particle by dt seconds under gravity and drop the expired ones
+void UpdateParticles(ParticlePool &pool, float dt);
+
+// 0 .. 1 as the particle ages
+float GetParticleAlpha(const ParticlePool &pool, int particle);
+
+#endif // PARTICLES_H
@@ -0,0 +1,180 @@
+#include "profiler.h"
+#include "event_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Ring of the most recent samples of one zone or counter
+struct ProfileHistory {
+  float samples[PROFILE_HISTORY];
+  int next;
+  int count;
+};
+
+// One timed scope, kept while capturing
+struct ProfileEvent {
+  ProfileZone zone;
+  double start;
+  double end;
+};
+
+//------------------------------------------------------------------------------------
+// Global Variables
+//------------------------------------------------------------------------------------
+std::atomic<bool> profilerEnabled(false);
+
+static const auto profileEpoch = std::chrono::steady_clock::now();
+static EventRing<ProfileEvent, PROFILE_SIM_SAMPLES> simSamples; // Sim -> main
+// Main thread only
+static ProfileHistory zoneHistory[PROFILE_ZONE_COUNT];
+static ProfileHistory counterHistory[PROFILE_COUNTER_COUNT];
+static std::atomic<int> frameCounters[PROFILE_COUNTER_COUNT];
+static std::vector<ProfileEvent> captureEvents;
+static bool capturing = false;
+
+static const char *zoneNames[PROFILE_ZONE_COUNT] = {
+    "sim tick", "sim balls", "sim movers", "sim powerups",
+    "frame",    "update",    "static",     "bricks",
+    "paddle",   "powerups",  "balls",      "particles",
+    "hud",      "present",    "input lag"};
+static const char *counterNames[PROFILE_COUNTER_COUNT] = {
+    "draw calls", "allocs", "particles", "events"};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void AddZoneSample(const ProfileEvent &event);
+static void PushSample(ProfileHistory &history, float value);
+static ProfileStats GetStats(const ProfileHistory &history);
+static bool IsSimulationZone(ProfileZone zone);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void SetProfilerEnabled(bool enabled) {
+  profilerEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+double GetProfileTime() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       profileEpoch)
+      .count();
+}
+
+// A full ring drops the sample; the overlay only loses a little history
+void RecordProfileSample(ProfileZone zone, double start, double end) {
+  if (IsSimulationZone(zone))
+    simSamples.Push({zone, start, end});
+  else
+    AddZoneSample({zone, start, end});
+}
+
+void CountProfileEvent(ProfileCounter counter, int amount) {
+  if (profilerEnabled.load(std::memory_order_relaxed))
+    frameCounters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void EndProfileFrame() {
+  ProfileEvent event;
+  while (simSamples.Pop(event))
+    AddZoneSample(event);
+  if (!profilerEnabled.load(std::memory_order_relaxed))
+    return;
+  for (int counter = 0; counter < PROFILE_COUNTER_COUNT; counter++) {
+    PushSample(counterHistory[counter],
+               static_cast<float>(frameCounters[counter].exchange(0)));
+  }
+}
+
+ProfileStats GetProfileZoneStats(ProfileZone zone) {
+  return GetStats(zoneHistory[zone]);
+}
+
+ProfileStats GetProfileCounterStats(ProfileCounter counter) {
+  return GetStats(counterHistory[counter]);
+}
+
+const char *GetProfileZoneName(ProfileZone zone) { return zoneNames[zone]; }
+
+const char *GetProfileCounterName(ProfileCounter counter) {
+  return counterNames[counter];
+}
+
+void StartProfileCapture() {
+  captureEvents.clear();
+  captureEvents.reserve(PROFILE_CAPTURE_EVENTS);
+  capturing = true;
+}
+
+bool IsProfileCapturing() { return capturing; }
+
+bool StopProfileCapture(const char *csvFileName, const char *traceFileName) {
+  std::vector<ProfileEvent> events;
+  capturing = false;
+  events.swap(captureEvents);
+
+  FILE *csv = std::fopen(csvFileName, "w");
+  if (csv != nullptr) {
+    std::fprintf(csv, "zone,thread,start_us,duration_us\n");
+    for (const auto &event : events) {
+      std::fprintf(csv, "%s,%s,%.1f,%.1f\n", zoneNames[event.zone],
+                   IsSimulationZone(event.zone) ? "sim" : "main",
+                   event.start * 1e6, (event.end - event.start) * 1e6);
+    }
+  }
+
+  // Chrome trace event format: complete ("X") events in microseconds
+  FILE *trace = std::fopen(traceFileName, "w");
+  if (trace != nullptr) {
+    std::fprintf(trace, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); i++) {
+      const ProfileEvent &event = events[i];
+      std::fprintf(trace,
+                   "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                   "\"ts\":%.1f,\"dur\":%.1f}%s\n",
+                   zoneNames[event.zone], IsSimulationZone(event.zone) ? 2 : 1,
+                   event.start * 1e6, (event.end - event.start) * 1e6,
+                   i + 1 < events.size() ? "," : "");
+    }
+    std::fprintf(trace, "]}\n");
+  }
+
+  const bool csvWritten = csv != nullptr && std::fclose(csv) == 0;
+  const bool traceWritten = trace != nullptr && std::fclose(trace) == 0;
+  return csvWritten && traceWritten;
+}
+
+void AddZoneSample(const ProfileEvent &event) {
+  PushSample(zoneHistory[event.zone],
+             static_cast<float>((event.end - event.start) * 1000.0));
+  if (capturing && captureEvents.size() < PROFILE_CAPTURE_EVENTS)
+    captureEvents.push_back(event);
+}
+
+void PushSample(ProfileHistory &history, float value) {
+  history.samples[history.next] = value;
+  history.next = (history.next + 1) % PROFILE_HISTORY;
+  history.count = std::min(history.count + 1, PROFILE_HISTORY);
+}
+
+ProfileStats GetStats(const ProfileHistory &history) {
+  ProfileStats stats = {0};
+  stats.samples = history.count;
+  if (history.count == 0)
+    return stats;
+
+  float sorted[PROFILE_HISTORY];
+  std::copy(history.samples, history.samples + history.count, sorted);
+  std::sort(sorted, sorted + history.count);
+  stats.p50 = sorted[(history.count - 1) / 2];
+  stats.p99 = sorted[(history.count - 1) * 99 / 100];
+  return stats;
+}
+
+bool IsSimulationZone(ProfileZone zone) { return zone < PROFILE_FRAME; }
@@ -0,0 +1,107 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Frame profiler: scoped timers around each subsystem, per-frame counters,
+// rolling p50/p99 for the overlay and captures exported as CSV and Chrome
+// trace JSON (chrome://tracing, Perfetto). Disabled it costs one relaxed
+// load per scope, so the core can stay instrumented in the bench.
+//
+// Simulation zones are timed on the simulation thread, every other zone and
+// all the functions below run on the main thread. The simulation thread
+// hands its samples over through a lock-free ring that EndProfileFrame()
+// drains, so timing a tick never waits on the renderer.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int PROFILE_HISTORY = 240;            // Samples kept per zone
+constexpr int PROFILE_CAPTURE_EVENTS = 1 << 20; // Events per capture
+constexpr int PROFILE_SIM_SAMPLES = 4096; // Simulation samples between frames
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(zone) \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+enum ProfileZone {
+  // Simulation thread
+  PROFILE_SIM_TICK,
+  PROFILE_SIM_BALLS, // Ball moves with brick and paddle collisions
+  PROFILE_SIM_MOVING_BRICKS,
+  PROFILE_SIM_POWERUPS,
+  // Main thread
+  PROFILE_FRAME,
+  PROFILE_UPDATE,
+  PROFILE_DRAW_STATIC_LAYER,
+  PROFILE_DRAW_BRICKS,
+  PROFILE_DRAW_PADDLE,
+  PROFILE_DRAW_POWERUPS,
+  PROFILE_DRAW_BALLS,
+  PROFILE_DRAW_PARTICLES, // Emission, update and the particle mesh
+  PROFILE_DRAW_HUD,
+  PROFILE_PRESENT, // EndDrawing: batch flush and buffer swap
+  PROFILE_INPUT_LATENCY, // Input poll to the present that first shows it
+  PROFILE_ZONE_COUNT
+};
+
+enum ProfileCounter {
+  PROFILE_DRAW_CALLS,  // Meshes and batch flushes submitted this frame
+  PROFILE_ALLOCATIONS, // Heap allocations on any thread during the frame
+  PROFILE_PARTICLES,   // Live particles drawn this frame
+  PROFILE_GAME_EVENTS, // Game events taken from the simulation this frame
+  PROFILE_COUNTER_COUNT
+};
+
+struct ProfileStats {
+  float p50;
+  float p99;
+  int samples;
+};
+
+extern std::atomic<bool> profilerEnabled;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void SetProfilerEnabled(bool enabled);
+double GetProfileTime(); // Seconds since the profiler started
+void RecordProfileSample(ProfileZone zone, double start, double end);
+void CountProfileEvent(ProfileCounter counter, int amount = 1);
+// Moves this frame's counters and the simulation's samples into their history
+void EndProfileFrame();
+
+// Rolling statistics; zones in milliseconds, counters per frame
+ProfileStats GetProfileZoneStats(ProfileZone zone);
+ProfileStats GetProfileCounterStats(ProfileCounter counter);
+const char *GetProfileZoneName(ProfileZone zone);
+const char *GetProfileCounterName(ProfileCounter counter);
+
+void StartProfileCapture();
+bool IsProfileCapturing();
+// Write the capture as CSV and Chrome trace JSON. Returns false if a file
+// could not be written.
+bool StopProfileCapture(const char *csvFileName, const char *traceFileName);
+
+// Times the enclosing block into zone while the profiler is enabled
+struct ProfileScope {
+  ProfileZone zone;
+  double start;
+
+  explicit ProfileScope(ProfileZone zone)
+      : zone(zone), start(profilerEnabled.load(std::memory_order_relaxed)
+                              ? GetProfileTime()
+                              : -1.0) {}
+  ~ProfileScope() {
+    if (start >= 0.0)
+      RecordProfileSample(zone, start, GetProfileTime());
+  }
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,318 @@
+#include "records.h"
+#include "raylib.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+static const char RECORD_MAGIC[4] = {'B', 'R', 'K', 'S'};
+constexpr int RECORD_HEADER_SIZE = 5;
+constexpr int RECORD_QUEUE_RESERVE = 64; // Queued records that never allocate
+
+//------------------------------------------------------------------------------------
+// Global Variables
+//------------------------------------------------------------------------------------
+static std::string storeFileName;
+static std::thread storeThread;
+static std::mutex storeMutex; // Guards everything below
+static std::condition_variable storeWake;
+static bool storeStopping = false;
+static std::vector<GameRecord> pendingRecords;
+static HighScoreTable highScores = {0};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static void StartRecordStore();
+static void StoreThread();
+static bool LoadRecords(HighScoreTable &table);
+static bool MoveAsideRecordLog();
+static FILE *OpenRecordLog();
+static bool WriteRecords(FILE *file, const std::vector<GameRecord> &records);
+static void InsertHighScore(HighScoreTable &table, const GameRecord &record);
+static void EncodeRecord(const GameRecord &record, uint8_t *out);
+static bool DecodeRecord(const uint8_t *in, GameRecord &record);
+static uint32_t HashBytes(const uint8_t *data, int size);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void OpenRecordStore(const char *fileName) {
+  CloseRecordStore();
+  storeFileName = fileName;
+  pendingRecords.reserve(RECORD_QUEUE_RESERVE);
+}
+
+void CloseRecordStore() {
+  {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    storeStopping = true;
+  }
+  storeWake.notify_one();
+  if (storeThread.joinable())
+    storeThread.join();
+  storeStopping = false;
+}
+
+void AppendGameRecord(const GameRecord &record) {
+  if (storeFileName.empty())
+    return;
+  StartRecordStore();
+  {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    pendingRecords.push_back(record);
+  }
+  storeWake.notify_one();
+}
+
+void GetHighScores(HighScoreTable &table) {
+  StartRecordStore();
+  std::lock_guard<std::mutex> lock(storeMutex);
+  table = highScores;
+}
+
+void AddFrameTime(FrameTimeStats &stats, float seconds) {
+  const float ms = seconds * 1000.0f;
+  const int bucket = std::min(static_cast<int>(ms / RECORD_FRAME_BUCKET_MS),
+                              RECORD_FRAME_BUCKETS - 1);
+  stats.buckets[std::max(bucket, 0)]++;
+  stats.frames++;
+  stats.maxMs = std::max(stats.maxMs, ms);
+}
+
+float GetFrameTimePercentile(const FrameTimeStats &stats, float fraction) {
+  const uint32_t rank = static_cast<uint32_t>(fraction * stats.frames);
+  uint32_t seen = 0;
+  for (int bucket = 0; bucket < RECORD_FRAME_BUCKETS; bucket++) {
+    seen += stats.buckets[bucket];
+    if (seen > rank)
+      return (bucket + 1) * RECORD_FRAME_BUCKET_MS;
+  }
+  return 0.0f;
+}
+
+// The writer starts with the first use, so a session that never reaches the
+// menu or finishes a game never touches the log
+void StartRecordStore() {
+  if (storeThread.joinable() || storeFileName.empty())
+    return;
+  storeThread = std::thread(StoreThread);
+}
+
+// Load the table, then wait for records. The first record of a batch opens
+// a RECORD_BATCH_MS window so games ending together share one write.
+void StoreThread() {
+  HighScoreTable loaded = {0};
+  const bool appendable = LoadRecords(loaded) || MoveAsideRecordLog();
+  loaded.loaded = true;
+  FILE *file = appendable ? OpenRecordLog() : nullptr;
+  if (file == nullptr)
+    TraceLog(LOG_WARNING, "Failed to open record log %s.",
+             storeFileName.c_str());
+
+  std::vector<GameRecord> batch;
+  batch.reserve(RECORD_QUEUE_RESERVE);
+  std::unique_lock<std::mutex> lock(storeMutex);
+  loaded.version = highScores.version + 1;
+  highScores = loaded;
+  while (true) {
+    storeWake.wait(lock,
+                   [] { return storeStopping || !pendingRecords.empty(); });
+    if (!storeStopping) {
+      storeWake.wait_for(lock, std::chrono::milliseconds(RECORD_BATCH_MS),
+                         [] { return storeStopping; });
+    }
+    batch.swap(pendingRecords);
+    const bool stopping = storeStopping;
+    lock.unlock();
+
+    if (!batch.empty() && file != nullptr && !WriteRecords(file, batch))
+      TraceLog(LOG_WARNING, "Failed to write record log %s.",
+               storeFileName.c_str());
+
+    lock.lock();
+    for (const auto &record : batch)
+      InsertHighScore(highScores, record);
+    if (!batch.empty())
+      highScores.version++;
+    batch.clear();
+    if (stopping && pendingRecords.empty())
+      break;
+  }
+  lock.unlock();
+  if (file != nullptr)
+    std::fclose(file);
+}
+
+// A missing log is an empty one. Returns false, loading nothing, for a file
+// with another header: another version's log, or not a log at all.
+bool LoadRecords(HighScoreTable &table) {
+  FILE *file = std::fopen(storeFileName.c_str(), "rb");
+  if (file == nullptr)
+    return true;
+  uint8_t header[RECORD_HEADER_SIZE];
+  uint8_t data[RECORD_SIZE];
+  GameRecord record;
+  int records = 0, skipped = 0;
+  if (std::fread(header, 1, sizeof(header), file) != sizeof(header)) {
+    std::fclose(file);
+    return true; // Torn before the first record, OpenRecordLog() restarts it
+  }
+  if (std::memcmp(header, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0 ||
+      header[4] != RECORD_VERSION) {
+    std::fclose(file);
+    return false;
+  }
+  while (std::fread(data, 1, sizeof(data), file) == sizeof(data)) {
+    if (DecodeRecord(data, record)) {
+      InsertHighScore(table, record);
+      records++;
+    } else {
+      skipped++;
+    }
+  }
+  std::fclose(file);
+  TraceLog(LOG_INFO, "GAME: Loaded %i game records from %s", records,
+           storeFileName.c_str());
+  if (skipped > 0)
+    TraceLog(LOG_WARNING, "Failed to read %i damaged game records.", skipped);
+  return true;
+}
+
+// Keep a log this build cannot read as fileName.old and start a new one
+bool MoveAsideRecordLog() {
+  const std::string oldName = storeFileName + ".old";
+  std::remove(oldName.c_str()); // rename() will not replace it on Windows
+  if (std::rename(storeFileName.c_str(), oldName.c_str()) != 0) {
+    TraceLog(LOG_WARNING, "Failed to move aside unreadable record log %s.",
+             storeFileName.c_str());
+    return false;
+  }
+  TraceLog(LOG_INFO, "GAME: Record log %s is not readable, kept as %s",
+           storeFileName.c_str(), oldName.c_str());
+  return true;
+}
+
+// For appending: a new log gets its header, a tail torn mid-record is
+// padded out to the next record boundary
+FILE *OpenRecordLog() {
+  FILE *file = std::fopen(storeFileName.c_str(), "ab");
+  if (file == nullptr || std::fseek(file, 0, SEEK_END) != 0) {
+    if (file != nullptr)
+      std::fclose(file);
+    return nullptr;
+  }
+  const long size = std::ftell(file);
+  if (size < RECORD_HEADER_SIZE) {
+    // Nothing worth keeping; a short header would fail the next load anyway
+    std::fclose(file);
+    file = std::fopen(storeFileName.c_str(), "wb");
+    if (file == nullptr)
+      return nullptr;
+    std::fwrite(RECORD_MAGIC, 1, sizeof(RECORD_MAGIC), file);
+    std::fputc(RECORD_VERSION, file);
+  } else {
+    const long torn = (size - RECORD_HEADER_SIZE) % RECORD_SIZE;
+    for (long i = torn; i > 0 && i < RECORD_SIZE; i++)
+      std::fputc(0, file);
+  }
+  return file;
+}
+
+// One fwrite and one fsync for the whole batch
+bool WriteRecords(FILE *file, const std::vector<GameRecord> &records) {
+  std::vector<uint8_t> data(records.size() * RECORD_SIZE);
+  for (size_t i = 0; i < records.size(); i++)
+    EncodeRecord(records[i], &data[i * RECORD_SIZE]);
+  if (std::fwrite(data.data(), 1, data.size(), file) != data.size() ||
+      std::fflush(file) != 0)
+    return false;
+#if defined(_WIN32)
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Ties keep the earlier game ahead
+void InsertHighScore(HighScoreTable &table, const GameRecord &record) {
+  if (record.autopilot)
+    return;
+  int slot = table.count;
+  while (slot > 0 && table.entries[slot - 1].score < record.score)
+    slot--;
+  if (slot >= RECORD_HIGH_SCORES)
+    return;
+  const int last = std::min(table.count, RECORD_HIGH_SCORES - 1);
+  for (int i = last; i > slot; i--)
+    table.entries[i] = table.entries[i - 1];
+  table.entries[slot] = record;
+  table.count = std::min(table.count + 1, RECORD_HIGH_SCORES);
+}
+
+void EncodeRecord(const GameRecord &record, uint8_t *out) {
+  uint8_t *cursor = out;
+  const auto put = [&cursor](uint64_t value, int count) {
+    for (int i = 0; i < count; i++)
+      *cursor++ = static_cast<uint8_t>(value >> (8 * i));
+  };
+  put(static_cast<uint64_t>(record.endTime), 8);
+  put(record.seed, 8);
+  put(static_cast<uint32_t>(record.score), 4);
+  put(record.level, 2);
+  put(record.difficulty, 1);
+  put(record.outcome, 1);
+  put(record.autopilot ? 1 : 0, 1);
+  put(record.ticks, 4);
+  put(record.powerUps, 2);
+  put(record.frameP50, 2);
+  put(record.frameP99, 2);
+  put(record.frameMax, 2);
+  put(HashBytes(out, RECORD_SIZE - 4), 4);
+}
+
+bool DecodeRecord(const uint8_t *in, GameRecord &record) {
+  const uint8_t *cursor = in;
+  const auto get = [&cursor](int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; i++)
+      value |= static_cast<uint64_t>(*cursor++) << (8 * i);
+    return value;
+  };
+  record.endTime = static_cast<int64_t>(get(8));
+  record.seed = get(8);
+  record.score = static_cast<int32_t>(get(4));
+  record.level = static_cast<uint16_t>(get(2));
+  record.difficulty = static_cast<uint8_t>(get(1));
+  record.outcome = static_cast<uint8_t>(get(1));
+  record.autopilot = get(1) != 0;
+  record.ticks = static_cast<uint32_t>(get(4));
+  record.powerUps = static_cast<uint16_t>(get(2));
+  record.frameP50 = static_cast<uint16_t>(get(2));
+  record.frameP99 = static_cast<uint16_t>(get(2));
+  record.frameMax = static_cast<uint16_t>(get(2));
+  return get(4) == HashBytes(in, RECORD_SIZE - 4);
+}
+
+// FNV-1a, 32 bit
+uint32_t HashBytes(const uint8_t *data, int size) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < size; i++)
+    hash = (hash ^ data[i]) * 16777619u;
+  return hash;
+}
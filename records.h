@@ -0,0 +1,91 @@
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <cstdint>
+
+//----------------------------------------------------------------------------------
+// Game records: one line of telemetry per finished game, appended to a local
+// log, and the high score table built from it. The main thread only queues
+// records and copies the table. A writer thread started on first use does
+// all the file work: it reads the log once to build the table, then appends
+// queued records in batches of at most one fsync each.
+//
+// Log layout (little endian):
+//   "BRKS", u8 version, then RECORD_SIZE-byte records:
+//   i64 end time (Unix seconds), u64 seed, i32 score, u16 level reached,
+//   u8 starting difficulty, u8 outcome, u8 autopilot, u32 ticks,
+//   u16 power-ups collected, u16 frame p50, p99 and max (1/100 ms),
+//   u32 FNV-1a of the record's preceding bytes
+// A record torn by a crash fails its checksum and is skipped, and the next
+// append starts at a record boundary again.
+// A file with another header is renamed to fileName.old and a new log begun.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr uint8_t RECORD_VERSION = 1;
+constexpr int RECORD_SIZE = 41;          // Bytes per record in the log
+constexpr int RECORD_HIGH_SCORES = 5;    // Entries in the table
+constexpr int RECORD_BATCH_MS = 500;     // Records gathered before a write
+constexpr float RECORD_FRAME_BUCKET_MS = 0.25f;
+constexpr int RECORD_FRAME_BUCKETS = 400; // Up to 100 ms, slower frames in
+                                          // the last bucket
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+enum RecordOutcome : uint8_t {
+  RECORD_LOST, // Out of lives or time
+  RECORD_WON,  // Ended on a cleared level
+  RECORD_QUIT  // Left mid-level for the menu or closed the window
+};
+
+struct GameRecord {
+  int64_t endTime; // Unix seconds
+  uint64_t seed;
+  int32_t score;
+  uint16_t level;     // Reached, 1 for the first
+  uint8_t difficulty; // Difficulty the game started at
+  uint8_t outcome;    // RecordOutcome
+  bool autopilot;     // Played by the computer, kept off the high scores
+  uint32_t ticks;     // Simulated, SIM_TICK_RATE per second of play
+  uint16_t powerUps;  // Collected
+  uint16_t frameP50;  // Frame times while playing, 1/100 ms
+  uint16_t frameP99;
+  uint16_t frameMax;
+};
+
+// Best scores, highest first. Copied out whole, so it is small.
+struct HighScoreTable {
+  GameRecord entries[RECORD_HIGH_SCORES];
+  int count;
+  bool loaded;          // False until the writer has read the log
+  unsigned int version; // Bumped on every change
+};
+
+// Histogram of one game's frame times, fixed size so adding never allocates
+struct FrameTimeStats {
+  uint32_t buckets[RECORD_FRAME_BUCKETS];
+  uint32_t frames;
+  float maxMs;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Use fileName for the log. Nothing is read or written before the first
+// AppendGameRecord() or GetHighScores().
+void OpenRecordStore(const char *fileName);
+// Write every queued record, then stop the writer
+void CloseRecordStore();
+
+void AppendGameRecord(const GameRecord &record); // Never waits on the disk
+void GetHighScores(HighScoreTable &table);
+
+void AddFrameTime(FrameTimeStats &stats, float seconds);
+// Upper edge of the bucket holding the fraction-th frame, in milliseconds
+float GetFrameTimePercentile(const FrameTimeStats &stats, float fraction);
+
+#endif // RECORDS_H
@@ -0,0 +1,244 @@
+#include "replay.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+static const char REPLAY_MAGIC[4] = {'B', 'R', 'K', 'R'};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static uint32_t GetPackHash(const GameWorld &world);
+static void WriteBytes(std::vector<uint8_t> &out, uint64_t value, int count);
+static void WriteFloat(std::vector<uint8_t> &out, float value);
+static void WriteVarint(std::vector<uint8_t> &out, uint32_t value);
+static bool ReadBytes(FILE *file, uint64_t &value, int count);
+static bool ReadVarint(FILE *file, uint32_t &value);
+static bool ReadFloat(FILE *file, float &value);
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void BeginReplay(Replay &replay, const GameWorld &world) {
+  replay.seed = world.seed;
+  replay.difficulty = world.difficulty;
+  replay.wallRows = world.wallRows;
+  replay.wallCols = world.wallCols;
+  replay.packHash = GetPackHash(world);
+  replay.tuning = world.tuning;
+  replay.runs.clear();
+}
+
+// Extend the last run when the input repeats, otherwise start a new one
+void RecordReplayTick(Replay &replay, uint8_t input) {
+  if (!replay.runs.empty() && replay.runs.back().input == input &&
+      replay.runs.back().ticks < UINT32_MAX)
+    replay.runs.back().ticks++;
+  else
+    replay.runs.push_back({input, 1});
+}
+
+bool SaveReplay(const Replay &replay, const char *fileName) {
+  std::vector<uint8_t> data(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+  data.push_back(REPLAY_VERSION);
+  data.push_back(static_cast<uint8_t>(replay.difficulty));
+  WriteBytes(data, replay.seed, 8);
+  WriteBytes(data, replay.wallRows, 2);
+  WriteBytes(data, replay.wallCols, 2);
+  WriteBytes(data, replay.packHash, 4);
+  WriteFloat(data, replay.tuning.powerUpChanceScale);
+  WriteFloat(data, replay.tuning.paddleWidthScale);
+  WriteFloat(data, replay.tuning.ballSpeedScale);
+  WriteBytes(data, replay.runs.size(), 4);
+  for (const auto &run : replay.runs) {
+    data.push_back(run.input);
+    WriteVarint(data, run.ticks);
+  }
+
+  FILE *file = std::fopen(fileName, "wb");
+  if (file == nullptr)
+    return false;
+  const bool written =
+      std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  return std::fclose(file) == 0 && written;
+}
+
+bool LoadReplay(Replay &replay, const char *fileName) {
+  FILE *file = std::fopen(fileName, "rb");
+  if (file == nullptr)
+    return false;
+
+  char magic[4] = {0};
+  uint64_t version = 0;
+  uint64_t difficulty = 0;
+  uint64_t seed = 0;
+  uint64_t wallRows = 0;
+  uint64_t wallCols = 0;
+  uint64_t packHash = 0;
+  GameTuning tuning = DEFAULT_TUNING;
+  uint64_t runCount = 0;
+  bool valid = std::fread(magic, 1, 4, file) == 4 &&
+               std::equal(magic, magic + 4, REPLAY_MAGIC) &&
+               ReadBytes(file, version, 1) && version >= 1 &&
+               version <= REPLAY_VERSION && ReadBytes(file, difficulty, 1) &&
+               difficulty < static_cast<uint64_t>(DIFFICULTY_COUNT) &&
+               ReadBytes(file, seed, 8);
+  if (valid && version >= 3) {
+    valid = ReadBytes(file, wallRows, 2) && ReadBytes(file, wallCols, 2) &&
+            wallRows <= MAX_GRID_ROWS && wallCols <= MAX_GRID_COLS &&
+            (wallRows == 0) == (wallCols == 0) &&
+            ReadBytes(file, packHash, 4) &&
+            ReadFloat(file, tuning.powerUpChanceScale) &&
+            ReadFloat(file, tuning.paddleWidthScale) &&
+            ReadFloat(file, tuning.ballSpeedScale);
+  }
+  valid = valid && ReadBytes(file, runCount, 4);
+
+  if (valid) {
+    replay.seed = seed;
+    replay.difficulty = static_cast<Difficulty>(difficulty);
+    replay.wallRows = static_cast<int>(wallRows);
+    replay.wallCols = static_cast<int>(wallCols);
+    replay.packHash = static_cast<uint32_t>(packHash);
+    replay.tuning = tuning;
+    replay.runs.clear();
+    replay.runs.reserve(std::min<uint64_t>(runCount, 1 << 16));
+    for (uint64_t i = 0; i < runCount && valid; i++) {
+      uint64_t input = 0;
+      uint32_t ticks = 0;
+      valid = ReadBytes(file, input, 1) && ReadVarint(file, ticks);
+      replay.runs.push_back({static_cast<uint8_t>(input), ticks});
+    }
+  }
+  std::fclose(file);
+  return valid;
+}
+
+uint32_t GetReplayTickCount(const Replay &replay) {
+  uint32_t ticks = 0;
+  for (const auto &run : replay.runs)
+    ticks += run.ticks;
+  return ticks;
+}
+
+bool NextReplayTick(const Replay &replay, ReplayCursor &cursor,
+                    uint8_t &input) {
+  while (cursor.run < replay.runs.size() &&
+         cursor.tick >= replay.runs[cursor.run].ticks) {
+    cursor.run++;
+    cursor.tick = 0;
+  }
+  if (cursor.run >= replay.runs.size())
+    return false;
+  input = replay.runs[cursor.run].input;
+  cursor.tick++;
+  return true;
+}
+
+bool StartReplay(GameWorld &world, const Replay &replay, ReplayCursor &cursor) {
+  if (GetPackHash(world) != replay.packHash)
+    return false;
+  world.wallRows = replay.wallRows;
+  world.wallCols = replay.wallCols;
+  StartGame(world, replay.difficulty, replay.seed, replay.tuning);
+  cursor = {0};
+  return true;
+}
+
+// Simulate the next recorded tick. Returns false at the end of the replay,
+// where the player left for the menu, or if the game no longer matches it.
+bool StepReplay(GameWorld &world, const Replay &replay, ReplayCursor &cursor) {
+  uint8_t input = 0;
+  if (!NextReplayTick(replay, cursor, input) || (input & REPLAY_MENU))
+    return false;
+  if ((input & REPLAY_NEXT_LEVEL) && world.status == LevelStatus::CLEARED)
+    AdvanceLevel(world);
+  if (world.status != LevelStatus::PLAYING)
+    return false;
+  UpdateSimulation(world, GetReplayGameInput(input));
+  return true;
+}
+
+GameInput GetReplayGameInput(uint8_t input) {
+  const int eighths = (input & REPLAY_ANALOG) >> REPLAY_ANALOG_SHIFT;
+  const float speed = (eighths == 0) ? 1.0f : eighths / 8.0f;
+  GameInput gameInput = {0};
+  if (input & REPLAY_LEFT)
+    gameInput.paddleMove -= speed;
+  if (input & REPLAY_RIGHT)
+    gameInput.paddleMove += speed;
+  return gameInput;
+}
+
+uint8_t GetReplayInput(float paddleMove) {
+  const int eighths = static_cast<int>(
+      std::lround(std::max(-1.0f, std::min(paddleMove, 1.0f)) * 8.0f));
+  if (eighths == 0)
+    return 0;
+  const uint8_t analog = static_cast<uint8_t>((std::abs(eighths) % 8)
+                                              << REPLAY_ANALOG_SHIFT);
+  return ((eighths < 0) ? REPLAY_LEFT : REPLAY_RIGHT) | analog;
+}
+
+uint32_t GetPackHash(const GameWorld &world) {
+  return (world.levelPack != nullptr) ? HashLevelPack(*world.levelPack) : 0;
+}
+
+void WriteBytes(std::vector<uint8_t> &out, uint64_t value, int count) {
+  for (int i = 0; i < count; i++)
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void WriteFloat(std::vector<uint8_t> &out, float value) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  WriteBytes(out, bits, 4);
+}
+
+// LEB128: seven bits per byte, high bit set while more bytes follow
+void WriteVarint(std::vector<uint8_t> &out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+bool ReadBytes(FILE *file, uint64_t &value, int count) {
+  value = 0;
+  for (int i = 0; i < count; i++) {
+    const int byte = std::fgetc(file);
+    if (byte == EOF)
+      return false;
+    value |= static_cast<uint64_t>(byte) << (8 * i);
+  }
+  return true;
+}
+
+bool ReadFloat(FILE *file, float &value) {
+  uint64_t bits = 0;
+  if (!ReadBytes(file, bits, 4))
+    return false;
+  const uint32_t low = static_cast<uint32_t>(bits);
+  std::memcpy(&value, &low, sizeof(value));
+  return true;
+}
+
+bool ReadVarint(FILE *file, uint32_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    const int byte = std::fgetc(file);
+    if (byte == EOF)
+      return false;
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
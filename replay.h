@@ -0,0 +1,84 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------
+// Replays: the seed, starting difficulty, board options and per-tick player
+// input of one game. With the deterministic core this is enough to rebuild
+// every tick. Version 1 files predate analog input and version 2 files the
+// board options; both load unchanged, as games on the default board.
+//
+// File layout (little endian):
+//   "BRKR", u8 version, u8 difficulty, u64 seed,
+//   u16 wall rows, u16 wall cols, u32 level pack hash (0 for none),
+//   f32 power-up chance, paddle width and ball speed scales,
+//   u32 run count, then per run: u8 input bits, varint tick count
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr uint8_t REPLAY_VERSION = 3;
+
+// Input bits recorded for each tick
+constexpr uint8_t REPLAY_LEFT = 1 << 0;       // Left arrow held
+constexpr uint8_t REPLAY_RIGHT = 1 << 1;      // Right arrow held
+constexpr uint8_t REPLAY_PAUSE = 1 << 2;      // [P] pressed since the last tick
+constexpr uint8_t REPLAY_NEXT_LEVEL = 1 << 3; // Advance a level before the tick
+constexpr uint8_t REPLAY_MENU = 1 << 4;       // [B] pressed, the game ends here
+// Analog input: the held arrow's paddle speed in eighths, 0 for full speed
+constexpr int REPLAY_ANALOG_SHIFT = 5;
+constexpr uint8_t REPLAY_ANALOG = 7 << REPLAY_ANALOG_SHIFT;
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// A run of consecutive ticks with identical input
+struct ReplayRun {
+  uint8_t input;
+  uint32_t ticks;
+};
+
+struct Replay {
+  uint64_t seed;
+  Difficulty difficulty;
+  int wallRows; // Generated wall size, 0 for the classic grid
+  int wallCols;
+  uint32_t packHash; // HashLevelPack() of the pack played, 0 for none
+  GameTuning tuning;
+  std::vector<ReplayRun> runs;
+};
+
+// Reads a replay back one tick at a time
+struct ReplayCursor {
+  size_t run;    // Current run
+  uint32_t tick; // Ticks already consumed from the current run
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Record the game world was just started with
+void BeginReplay(Replay &replay, const GameWorld &world);
+void RecordReplayTick(Replay &replay, uint8_t input);
+bool SaveReplay(const Replay &replay, const char *fileName);
+bool LoadReplay(Replay &replay, const char *fileName);
+uint32_t GetReplayTickCount(const Replay &replay);
+
+// Returns false once every recorded tick has been read
+bool NextReplayTick(const Replay &replay, ReplayCursor &cursor,
+                    uint8_t &input);
+// Start the recorded game on the board it was played on. Returns false,
+// leaving world unchanged, unless world.levelPack is the pack recorded.
+bool StartReplay(GameWorld &world, const Replay &replay, ReplayCursor &cursor);
+bool StepReplay(GameWorld &world, const Replay &replay, ReplayCursor &cursor);
+GameInput GetReplayGameInput(uint8_t input); // Paddle intent of input bits
+
+// Held-input bits for a paddle move of -1 .. 1, rounded to the nearest eighth
+uint8_t GetReplayInput(float paddleMove);
+
+#endif // REPLAY_H
@@ -0,0 +1,97 @@
+#include "session.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+void StartSession(GameSession &session, Difficulty diff, uint64_t seed,
+                  bool record) {
+  StartGame(session.world, diff, seed);
+  session.state = GameState::PLAYING;
+  session.paused = false;
+  session.startDifficulty = diff;
+  session.recording = record;
+  session.pendingEvents = 0;
+  if (record)
+    BeginReplay(session.replay, session.world);
+}
+
+void StepSession(GameSession &session, uint8_t input) {
+  switch (session.state) {
+  case GameState::MENU:
+    break;
+
+  case GameState::PLAYING:
+    if (input & REPLAY_MENU) {
+      if (session.recording)
+        RecordReplayTick(session.replay, REPLAY_MENU);
+      session.state = GameState::MENU;
+      session.paused = false;
+      break;
+    }
+    if (input & REPLAY_PAUSE) {
+      session.paused = !session.paused;
+      if (session.paused)
+        session.pendingEvents |= REPLAY_PAUSE;
+    }
+    if (session.paused)
+      break;
+
+    UpdateSimulation(session.world, GetReplayGameInput(input));
+    if (session.recording) {
+      RecordReplayTick(session.replay,
+                       (input & (REPLAY_LEFT | REPLAY_RIGHT | REPLAY_ANALOG)) |
+                           session.pendingEvents);
+    }
+    session.pendingEvents = 0;
+    if (session.world.status == LevelStatus::LOST)
+      session.state = GameState::GAME_OVER;
+    else if (session.world.status == LevelStatus::CLEARED)
+      session.state = GameState::YOU_WIN;
+    break;
+
+  case GameState::GAME_OVER:
+    if (input & (REPLAY_NEXT_LEVEL | REPLAY_MENU))
+      session.state = GameState::MENU;
+    break;
+
+  case GameState::YOU_WIN:
+    if ((input & REPLAY_NEXT_LEVEL) && AdvanceLevel(session.world)) {
+      session.pendingEvents |= REPLAY_NEXT_LEVEL;
+      session.state = GameState::PLAYING;
+    } else if (input & (REPLAY_NEXT_LEVEL | REPLAY_MENU)) {
+      session.state = GameState::MENU;
+    }
+    break;
+  }
+}
+
+int GetSessionLevel(const GameSession &session) { return session.world.level; }
+
+int HoldStressLoad(GameSession &session, int balls, int powerUps) {
+  GameWorld &world = session.world;
+  if (session.state == GameState::GAME_OVER ||
+      session.state == GameState::YOU_WIN) {
+    SetupLevel(world, world.difficulty);
+    session.state = GameState::PLAYING;
+  }
+  world.lives = std::max(world.lives, STRESS_LIVES);
+  world.countdownTimer = GetDifficultyConfig(world.difficulty).timeLimit;
+  return SpawnStressLoad(world, balls, powerUps);
+}
+
+size_t GetSessionMemoryUsage(const GameSession &session) {
+  const BrickStore &bricks = session.world.bricks;
+  return sizeof(GameSession) +
+         (bricks.x.capacity() + bricks.y.capacity() + bricks.width.capacity() +
+          bricks.height.capacity() + bricks.prevX.capacity() +
+          bricks.moveSpeed.capacity()) *
+             sizeof(float) +
+         bricks.hitsRequired.capacity() * sizeof(int) +
+         bricks.color.capacity() * sizeof(Color) +
+         bricks.activeMask.capacity() * sizeof(uint64_t) +
+         bricks.rowActive.capacity() * sizeof(int) +
+         session.world.movingBricks.capacity() * sizeof(int) +
+         session.replay.runs.capacity() * sizeof(ReplayRun);
+}
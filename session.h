@@ -0,0 +1,56 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "game.h"
+#include "replay.h"
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------
+// A game session: one player's world plus the flow around it (pause, result
+// screens, level transitions, recording). Sessions share no state, so a
+// server can host any number of them and step each from any thread.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int STRESS_LIVES = 3; // Held by HoldStressLoad(), a tick costs one
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+enum class GameState { MENU, PLAYING, GAME_OVER, YOU_WIN };
+
+struct GameSession {
+  GameWorld world;
+  GameState state;
+  bool paused;
+  Difficulty startDifficulty; // Level 1 of this game
+  bool recording;             // Ticks are appended to replay
+  uint8_t pendingEvents;      // REPLAY_* events recorded with the next tick
+  Replay replay;
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void StartSession(GameSession &session, Difficulty diff, uint64_t seed,
+                  bool record);
+
+// Advance one tick. input holds REPLAY_* bits: held arrows (at REPLAY_ANALOG
+// speed), [P] toggles the pause, [B] (REPLAY_MENU) ends the game and [ENTER]
+// on a result screen (REPLAY_NEXT_LEVEL) moves on to the next level or back
+// to the menu.
+void StepSession(GameSession &session, uint8_t input);
+int GetSessionLevel(const GameSession &session); // 1 for the first level
+
+// Before a stress test tick: top the world up with SpawnStressLoad(), refill
+// lives and time, and replay a level that ended, so the load holds however
+// fast the balls clear the wall. Returns the spawns the pools refused.
+int HoldStressLoad(GameSession &session, int balls, int powerUps);
+
+// Bytes owned by the session, inline and on the heap
+size_t GetSessionMemoryUsage(const GameSession &session);
+
+#endif // SESSION_H
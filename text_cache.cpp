@@ -0,0 +1,86 @@
+#include "text_cache.h"
+#include "rlgl.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int DEFAULT_FONT_SIZE = 10; // DrawText() never draws smaller
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+// Same layout and width as raylib's DrawTextEx() and MeasureTextEx() with the
+// spacing DrawText() picks. Text is single line ASCII.
+void LayoutTextRun(TextRun &run, const char *text, int fontSize, int key) {
+  const Font font = GetFontDefault();
+  if (fontSize < DEFAULT_FONT_SIZE)
+    fontSize = DEFAULT_FONT_SIZE;
+  const float scale = static_cast<float>(fontSize) / font.baseSize;
+  const float spacing = static_cast<float>(fontSize / DEFAULT_FONT_SIZE);
+  const float padding = static_cast<float>(font.glyphPadding);
+  const float atlasWidth = static_cast<float>(font.texture.width);
+  const float atlasHeight = static_cast<float>(font.texture.height);
+
+  run.key = key;
+  run.fontSize = fontSize;
+  run.texture = font.texture.id;
+  run.glyphCount = 0;
+  float x = 0.0f;
+  float measured = 0.0f;
+  int length = 0;
+  for (; text[length] != '\0' && length < TEXT_RUN_CAPACITY; length++) {
+    const char c = text[length];
+    const int index = GetGlyphIndex(font, static_cast<unsigned char>(c));
+    const Rectangle rec = font.recs[index];
+    const GlyphInfo &glyph = font.glyphs[index];
+    if (c != ' ' && c != '\t') {
+      TextGlyph &quad = run.glyphs[run.glyphCount++];
+      quad.quad = {x + (glyph.offsetX - padding) * scale,
+                   (glyph.offsetY - padding) * scale,
+                   (rec.width + 2.0f * padding) * scale,
+                   (rec.height + 2.0f * padding) * scale};
+      quad.u0 = (rec.x - padding) / atlasWidth;
+      quad.v0 = (rec.y - padding) / atlasHeight;
+      quad.u1 = (rec.x + rec.width + padding) / atlasWidth;
+      quad.v1 = (rec.y + rec.height + padding) / atlasHeight;
+    }
+    x += ((glyph.advanceX == 0) ? rec.width : glyph.advanceX) * scale +
+         spacing;
+    measured += (glyph.advanceX == 0) ? rec.width + glyph.offsetX
+                                      : glyph.advanceX;
+  }
+  run.width =
+      (length > 0) ? static_cast<int>(measured * scale + (length - 1) * spacing)
+                   : 0;
+}
+
+bool TextRunNeedsLayout(const TextRun &run, int key) {
+  return run.fontSize == 0 || run.key != key;
+}
+
+void DrawTextRun(const TextRun &run, float x, float y, Color color) {
+  if (run.glyphCount == 0 || run.texture == 0)
+    return;
+  rlCheckRenderBatchLimit(4 * run.glyphCount);
+  rlSetTexture(run.texture);
+  rlBegin(RL_QUADS);
+  rlColor4ub(color.r, color.g, color.b, color.a);
+  for (int i = 0; i < run.glyphCount; i++) {
+    const TextGlyph &glyph = run.glyphs[i];
+    const float left = x + glyph.quad.x;
+    const float top = y + glyph.quad.y;
+    const float right = left + glyph.quad.width;
+    const float bottom = top + glyph.quad.height;
+    rlTexCoord2f(glyph.u0, glyph.v0);
+    rlVertex2f(left, top);
+    rlTexCoord2f(glyph.u0, glyph.v1);
+    rlVertex2f(left, bottom);
+    rlTexCoord2f(glyph.u1, glyph.v1);
+    rlVertex2f(right, bottom);
+    rlTexCoord2f(glyph.u1, glyph.v0);
+    rlVertex2f(right, top);
+  }
+  rlEnd();
+  rlSetTexture(0);
+}
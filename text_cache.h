@@ -0,0 +1,50 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Laid-out text in raylib's default font. A TextRun holds the quads DrawText()
+// would emit for a string, so drawing it skips the per-character glyph lookup
+// and layout. Runs are rebuilt only when their text changes: a HUD value keys
+// its run, and static strings are laid out once.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int TEXT_RUN_CAPACITY = 40; // Glyphs per run, longer text is cut
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// One glyph quad relative to the run's origin, with its atlas coordinates
+struct TextGlyph {
+  Rectangle quad;
+  float u0, v0, u1, v1;
+};
+
+struct TextRun {
+  int key;              // Value the text was laid out for
+  int fontSize;         // 0 until the first layout
+  unsigned int texture; // Font atlas
+  int width;            // Same as MeasureText()
+  int glyphCount;
+  TextGlyph glyphs[TEXT_RUN_CAPACITY];
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Lay text out as DrawText(text, 0, 0, fontSize, ...) would. Needs a window.
+void LayoutTextRun(TextRun &run, const char *text, int fontSize, int key = 0);
+
+// True if the run was never laid out or was laid out for another key
+bool TextRunNeedsLayout(const TextRun &run, int key);
+
+// Submit every glyph of the run in one batch
+void DrawTextRun(const TextRun &run, float x, float y, Color color);
+
+#endif // TEXT_CACHE_H
@@ -0,0 +1,46 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+//----------------------------------------------------------------------------------
+// Lock-free handoff of the newest value from one producer thread to one
+// consumer thread. The producer fills Back() and publishes it; the consumer
+// reads Latest(). Neither side ever waits, and values the consumer did not
+// get to in time are simply overwritten.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Defines and Global Constants
+//----------------------------------------------------------------------------------
+constexpr int TRIPLE_BUFFER_INDEX = 3; // Slot index bits of middle
+constexpr int TRIPLE_BUFFER_FRESH = 4; // middle was published, not yet read
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+template <typename T> struct TripleBuffer {
+  T slots[3];
+  int back = 0;               // Being written, producer only
+  int front = 1;              // Being read, consumer only
+  std::atomic<int> middle{2}; // Last published slot
+
+  T &Back() { return slots[back]; }
+
+  // Hand the back slot to the consumer and take the unused one in return
+  void Publish() {
+    back = middle.exchange(back | TRIPLE_BUFFER_FRESH,
+                           std::memory_order_acq_rel) &
+           TRIPLE_BUFFER_INDEX;
+  }
+
+  // The most recently published value; stays valid until the next call
+  const T &Latest() {
+    if (middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH)
+      front = middle.exchange(front, std::memory_order_acq_rel) &
+              TRIPLE_BUFFER_INDEX;
+    return slots[front];
+  }
+};
+
+#endif // TRIPLE_BUFFER_H
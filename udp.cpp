@@ -0,0 +1,128 @@
+#include "udp.h"
+#include <cstring>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#endif
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+static bool StartSockets();
+
+//------------------------------------------------------------------------------------
+// Module Functions Definitions
+//------------------------------------------------------------------------------------
+
+bool OpenUdpSender(UdpSocket &udp, const char *host, int port) {
+  udp.handle = -1;
+  if (!StartSockets())
+    return false;
+
+  addrinfo hints = {0};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr)
+    return false;
+  udp.peerAddress =
+      reinterpret_cast<sockaddr_in *>(result->ai_addr)->sin_addr.s_addr;
+  udp.peerPort = htons(static_cast<uint16_t>(port));
+  freeaddrinfo(result);
+
+  const SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (static_cast<intptr_t>(handle) < 0)
+    return false;
+  const int enable = 1;
+  setsockopt(handle, SOL_SOCKET, SO_BROADCAST,
+             reinterpret_cast<const char *>(&enable), sizeof(enable));
+  udp.handle = static_cast<intptr_t>(handle);
+  return true;
+}
+
+bool OpenUdpReceiver(UdpSocket &udp, int port) {
+  udp.handle = -1;
+  udp.peerAddress = 0;
+  udp.peerPort = 0;
+  if (!StartSockets())
+    return false;
+
+  const SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (static_cast<intptr_t>(handle) < 0)
+    return false;
+  const int enable = 1;
+  setsockopt(handle, SOL_SOCKET, SO_REUSEADDR,
+             reinterpret_cast<const char *>(&enable), sizeof(enable));
+
+  sockaddr_in address = {0};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(static_cast<uint16_t>(port));
+#if defined(_WIN32)
+  u_long nonBlocking = 1;
+  const bool configured = ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+  const bool configured =
+      fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+  udp.handle = static_cast<intptr_t>(handle);
+  if (!configured || bind(handle, reinterpret_cast<sockaddr *>(&address),
+                          sizeof(address)) != 0) {
+    CloseUdp(udp);
+    return false;
+  }
+  return true;
+}
+
+bool SendUdp(const UdpSocket &udp, const uint8_t *data, size_t size) {
+  sockaddr_in address = {0};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = udp.peerAddress;
+  address.sin_port = udp.peerPort;
+  return sendto(static_cast<SocketHandle>(udp.handle),
+                reinterpret_cast<const char *>(data), static_cast<int>(size),
+                0, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == static_cast<int>(size);
+}
+
+int ReceiveUdp(const UdpSocket &udp, uint8_t *buffer, size_t capacity) {
+  const auto received =
+      recvfrom(static_cast<SocketHandle>(udp.handle),
+               reinterpret_cast<char *>(buffer), static_cast<int>(capacity), 0,
+               nullptr, nullptr);
+  return received < 0 ? -1 : static_cast<int>(received);
+}
+
+void CloseUdp(UdpSocket &udp) {
+  if (udp.handle < 0)
+    return;
+#if defined(_WIN32)
+  closesocket(static_cast<SocketHandle>(udp.handle));
+#else
+  close(static_cast<SocketHandle>(udp.handle));
+#endif
+  udp.handle = -1;
+}
+
+// Winsock needs initializing once per process; other platforms need nothing
+bool StartSockets() {
+#if defined(_WIN32)
+  static bool started = false;
+  WSADATA data;
+  if (!started)
+    started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+  return started;
+#else
+  return true;
+#endif
+}
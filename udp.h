@@ -0,0 +1,36 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------
+// Minimal IPv4 UDP sockets for the spectator stream. Kept apart from raylib
+// so the system socket headers never meet raylib's names.
+//----------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct UdpSocket {
+  intptr_t handle;      // Socket descriptor, -1 when closed
+  uint32_t peerAddress; // Destination of SendUdp, network byte order
+  uint16_t peerPort;    // Network byte order
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+
+// Socket sending to host:port. host may be a broadcast address.
+bool OpenUdpSender(UdpSocket &socket, const char *host, int port);
+
+// Non-blocking socket bound to port on every interface
+bool OpenUdpReceiver(UdpSocket &socket, int port);
+bool SendUdp(const UdpSocket &socket, const uint8_t *data, size_t size);
+
+// Size of the next pending datagram, or -1 when none is waiting
+int ReceiveUdp(const UdpSocket &socket, uint8_t *buffer, size_t capacity);
+void CloseUdp(UdpSocket &socket);
+
+#endif // UDP_H